@@ -0,0 +1,43 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "allocationCounter.h"
+
+#ifdef GCTS_COUNT_HEAP_ALLOCATIONS
+
+// global operator new & delete are replaced to count allocations. array
+// forms of the standard library forward to these ones. over-aligned
+// allocations are not counted
+
+static std::atomic<size_t> heapAllocationCount = 0;
+
+void *operator new(size_t size)
+{
+    heapAllocationCount.fetch_add(1, std::memory_order_relaxed);
+
+    if(void *ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+GCTS_BEGIN
+
+size_t getHeapAllocationCount() noexcept
+{
+    return heapAllocationCount.load(std::memory_order_relaxed);
+}
+
+GCTS_END
+
+#endif
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+
+#include "synthesizer.h"
+
+GCTS_BEGIN
+
+#ifdef GCTS_COUNT_HEAP_ALLOCATIONS
+
+// number of heap allocations made through global operator new by all
+// threads so far. used to check that steady-state iterations don't allocate.
+// enabled by the GCTS_COUNT_HEAP_ALLOCATIONS cmake option
+size_t getHeapAllocationCount() noexcept;
+
+#endif
+
+GCTS_END
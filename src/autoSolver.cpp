@@ -0,0 +1,28 @@
+#include "autoSolver.h"
+
+GCTS_BEGIN
+
+AutoSolver::AutoSolver(ThreadPool &threadPool) noexcept
+    : pushRelabel_(threadPool)
+{
+
+}
+
+void AutoSolver::setDeadline(Clock::time_point deadline) noexcept
+{
+    bk_.setDeadline(deadline);
+    pushRelabel_.setDeadline(deadline);
+}
+
+const MinCutResult &AutoSolver::findMinCut(const Graph &graph)
+{
+    return isLarge(graph) ? pushRelabel_.findMinCut(graph)
+                          : bk_.findMinCut(graph);
+}
+
+bool AutoSolver::isLarge(const Graph &graph) noexcept
+{
+    return graph.getVertexCount() >= PUSH_RELABEL_MIN_VERTEX_COUNT;
+}
+
+GCTS_END
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "bkSolver.h"
+#include "pushRelabelSolver.h"
+
+GCTS_BEGIN
+
+/*
+ * serial BKSolver for small graphs, and parallel PushRelabelSolver for large
+ * ones that would leave most cores idle
+ */
+class AutoSolver : public MaxFlowSolver
+{
+public:
+
+    // graphs with at least so many vertices are solved in parallel
+    static constexpr Graph::Index PUSH_RELABEL_MIN_VERTEX_COUNT = 1 << 16;
+
+    explicit AutoSolver(ThreadPool &threadPool) noexcept;
+
+    void setDeadline(Clock::time_point deadline) noexcept override;
+
+    const MinCutResult &findMinCut(const Graph &graph) override;
+
+private:
+
+    static bool isLarge(const Graph &graph) noexcept;
+
+    BKSolver          bk_;
+    PushRelabelSolver pushRelabel_;
+};
+
+GCTS_END
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "synthesizer.h"
+
+GCTS_BEGIN
+
+class Bitmap
+{
+public:
+
+    Bitmap() = default;
+
+    explicit Bitmap(size_t size, bool value = false)
+    {
+        assign(size, value);
+    }
+
+    void assign(size_t size, bool value)
+    {
+        size_ = size;
+        words_.assign((size + 63) / 64, value ? ~std::uint64_t(0) : 0);
+        if(value && size % 64)
+            words_.back() = (std::uint64_t(1) << (size % 64)) - 1;
+    }
+
+    // new bits are initialized with false
+    void resize(size_t size)
+    {
+        size_ = size;
+        words_.resize((size + 63) / 64, 0);
+        if(size % 64)
+            words_.back() &= (std::uint64_t(1) << (size % 64)) - 1;
+    }
+
+    void clear() noexcept
+    {
+        size_ = 0;
+        words_.clear();
+    }
+
+    // bits out of range are always zero
+    bool operator==(const Bitmap &rhs) const noexcept
+    {
+        return size_ == rhs.size_ && words_ == rhs.words_;
+    }
+
+    bool operator!=(const Bitmap &rhs) const noexcept
+    {
+        return !(*this == rhs);
+    }
+
+    size_t size() const noexcept
+    {
+        return size_;
+    }
+
+    bool test(size_t i) const noexcept
+    {
+        return (words_[i / 64] >> (i % 64)) & 1;
+    }
+
+    bool operator[](size_t i) const noexcept
+    {
+        return test(i);
+    }
+
+    void set(size_t i) noexcept
+    {
+        words_[i / 64] |= std::uint64_t(1) << (i % 64);
+    }
+
+    void set(size_t i, bool value) noexcept
+    {
+        if(value)
+            set(i);
+        else
+            reset(i);
+    }
+
+    void reset(size_t i) noexcept
+    {
+        words_[i / 64] &= ~(std::uint64_t(1) << (i % 64));
+    }
+
+    // index of the first unset bit in [from, size). size if not found
+    size_t findNextUnset(size_t from) const noexcept
+    {
+        for(size_t w = from / 64; w < words_.size(); ++w)
+        {
+            std::uint64_t unset = ~words_[w];
+            if(w == from / 64)
+                unset &= ~std::uint64_t(0) << (from % 64);
+
+            if(unset)
+            {
+                size_t i = w * 64;
+                while(!(unset & 1))
+                {
+                    unset >>= 1;
+                    ++i;
+                }
+                return std::min(i, size_);
+            }
+        }
+        return size_;
+    }
+
+private:
+
+    std::vector<std::uint64_t> words_;
+    size_t size_ = 0;
+};
+
+GCTS_END
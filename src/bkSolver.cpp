@@ -0,0 +1,326 @@
+#include "bkSolver.h"
+
+GCTS_BEGIN
+
+const MinCutResult &BKSolver::findMinCut(const Graph &graph)
+{
+    graph_ = &graph;
+    initSearchTrees();
+    return runMaxFlow();
+}
+
+void BKSolver::initSearchTrees()
+{
+    const Index vtxCount  = graph_->getVertexCount();
+    const Index edgeCount = graph_->getEdgeCount();
+
+    capacities_.resize(edgeCount);
+    for(Index e = 0; e < edgeCount; ++e)
+        capacities_[e] = graph_->getEdgeCapacity(e);
+
+    flows_.assign(edgeCount, 0);
+    terminalRes_.resize(vtxCount);
+
+    trees_.resize(vtxCount);
+    parents_.assign(vtxCount, NIL);
+    timestamps_.assign(vtxCount, 0);
+    dists_.assign(vtxCount, 0);
+    isActive_.assign(vtxCount, false);
+
+    activeVtces_.clear();
+    orphans_.clear();
+    time_ = 0;
+
+    for(Index v = 0; v < vtxCount; ++v)
+    {
+        terminalRes_[v] = graph_->getTerminalCapacity(v);
+
+        if(terminalRes_[v])
+        {
+            trees_[v]   = terminalRes_[v] > 0 ? SrcTree : SinkTree;
+            parents_[v] = TERMINAL;
+            dists_[v]   = 1;
+            activate(v);
+        }
+        else
+            trees_[v] = Free;
+    }
+}
+
+const MinCutResult &BKSolver::runMaxFlow()
+{
+    // find max flow. trees are consistent between augmentations, so the
+    // search can stop there when the deadline passes
+
+    int augmentCount = 0;
+    for(Index meetArc; (meetArc = grow()) != NIL;)
+    {
+        ++time_;
+        augment(meetArc);
+        adopt();
+
+        if(++augmentCount % DEADLINE_CHECK_INTERVAL == 0 && isPastDeadline())
+            break;
+    }
+
+    // vertices in src tree are exactly the ones reachable from src in res
+    // graph. when stopped early, src tree still contains all src vertices
+    // and no sink vertex, and thus gives a cut
+
+    MinCutResult &ret = result_;
+
+    const Index vtxCount = graph_->getVertexCount();
+    ret.reachableVertices.assign(vtxCount, false);
+    for(Index v = 0; v < vtxCount; ++v)
+    {
+        if(trees_[v] == SrcTree)
+            ret.reachableVertices.set(v);
+    }
+
+    findCutEdges(*graph_, ret);
+
+    return ret;
+}
+
+void BKSolver::activate(Index v)
+{
+    if(!isActive_[v])
+    {
+        isActive_.set(v);
+        activeVtces_.push_back(v);
+    }
+}
+
+BKSolver::Index BKSolver::grow()
+{
+    while(!activeVtces_.empty())
+    {
+        const Index v = activeVtces_.front();
+
+        if(trees_[v] != Free)
+        {
+            const bool inSrcTree = trees_[v] == SrcTree;
+
+            Index meetArc = NIL;
+            graph_->forEachArc(v, [&](Index arc, Index u)
+            {
+                if(res(inSrcTree ? arc : sister(arc)) <= 0)
+                    return false;
+
+                if(trees_[u] == Free)
+                {
+                    trees_[u]      = trees_[v];
+                    parents_[u]    = sister(arc);
+                    timestamps_[u] = timestamps_[v];
+                    dists_[u]      = dists_[v] + 1;
+                    activate(u);
+                }
+                else if(trees_[u] != trees_[v])
+                {
+                    meetArc = inSrcTree ? arc : sister(arc);
+                    return true;
+                }
+                else if(timestamps_[u] <= timestamps_[v] &&
+                        dists_[u] > dists_[v])
+                {
+                    // shorten the path from u to its root
+
+                    parents_[u]    = sister(arc);
+                    timestamps_[u] = timestamps_[v];
+                    dists_[u]      = dists_[v] + 1;
+                }
+
+                return false;
+            });
+
+            // v stays active so that its remaining arcs are examined in the
+            // next growth stage
+
+            if(meetArc != NIL)
+                return meetArc;
+        }
+
+        isActive_.reset(v);
+        activeVtces_.pop_front();
+    }
+
+    return NIL;
+}
+
+void BKSolver::augment(Index meetArc)
+{
+    const Index s = head(sister(meetArc));
+    const Index t = head(meetArc);
+
+    // find capacity of the path
+
+    int pathRes = res(meetArc);
+
+    Index v = s;
+    for(; parents_[v] != TERMINAL; v = head(parents_[v]))
+        pathRes = std::min(pathRes, res(sister(parents_[v])));
+    pathRes = std::min(pathRes, terminalRes_[v]);
+
+    for(v = t; parents_[v] != TERMINAL; v = head(parents_[v]))
+        pathRes = std::min(pathRes, res(parents_[v]));
+    pathRes = std::min(pathRes, -terminalRes_[v]);
+
+    // update edge flow. vertices whose parent arcs get saturated become orphans
+
+    push(meetArc, pathRes);
+
+    for(v = s; parents_[v] != TERMINAL;)
+    {
+        const Index arc = parents_[v];
+        push(sister(arc), pathRes);
+
+        if(!res(sister(arc)))
+        {
+            parents_[v] = NIL;
+            orphans_.push_back(v);
+        }
+
+        v = head(arc);
+    }
+
+    terminalRes_[v] -= pathRes;
+    if(!terminalRes_[v])
+    {
+        parents_[v] = NIL;
+        orphans_.push_back(v);
+    }
+
+    for(v = t; parents_[v] != TERMINAL;)
+    {
+        const Index arc = parents_[v];
+        push(arc, pathRes);
+
+        if(!res(arc))
+        {
+            parents_[v] = NIL;
+            orphans_.push_back(v);
+        }
+
+        v = head(arc);
+    }
+
+    terminalRes_[v] += pathRes;
+    if(!terminalRes_[v])
+    {
+        parents_[v] = NIL;
+        orphans_.push_back(v);
+    }
+}
+
+void BKSolver::adopt()
+{
+    while(!orphans_.empty())
+    {
+        const Index v = orphans_.front();
+        orphans_.pop_front();
+
+        // v may have been attached to a terminal after becoming an orphan
+        if(parents_[v] == NIL)
+            adoptOrphan(v);
+    }
+}
+
+void BKSolver::adoptOrphan(Index v)
+{
+    constexpr int INF_DIST = std::numeric_limits<int>::max();
+
+    const bool inSrcTree = trees_[v] == SrcTree;
+
+    // try to find a new valid parent
+
+    Index newParent = NIL;
+    int minDist = INF_DIST;
+
+    graph_->forEachArc(v, [&](Index arc, Index u)
+    {
+        if(trees_[u] != trees_[v] || parents_[u] == NIL)
+            return false;
+
+        if(res(inSrcTree ? sister(arc) : arc) <= 0)
+            return false;
+
+        // check whether u originates from a terminal
+
+        int dist = 0;
+        for(Index w = u;;)
+        {
+            if(timestamps_[w] == time_)
+            {
+                dist += dists_[w];
+                break;
+            }
+
+            ++dist;
+
+            if(parents_[w] == TERMINAL)
+            {
+                timestamps_[w] = time_;
+                dists_[w]      = 1;
+                break;
+            }
+
+            if(parents_[w] == NIL)
+            {
+                dist = INF_DIST;
+                break;
+            }
+
+            w = head(parents_[w]);
+        }
+
+        if(dist == INF_DIST)
+            return false;
+
+        if(dist < minDist)
+        {
+            newParent = arc;
+            minDist   = dist;
+        }
+
+        // cache distances along the path
+
+        for(Index w = u; timestamps_[w] != time_; w = head(parents_[w]))
+        {
+            timestamps_[w] = time_;
+            dists_[w]      = dist--;
+        }
+
+        return false;
+    });
+
+    if(newParent != NIL)
+    {
+        parents_[v]    = newParent;
+        timestamps_[v] = time_;
+        dists_[v]      = minDist + 1;
+        return;
+    }
+
+    // no parent is found. v becomes free and its children become orphans
+
+    graph_->forEachArc(v, [&](Index arc, Index u)
+    {
+        if(trees_[u] != trees_[v])
+            return false;
+
+        if(res(inSrcTree ? sister(arc) : arc) > 0)
+            activate(u);
+
+        if(parents_[u] == sister(arc))
+        {
+            parents_[u] = NIL;
+            orphans_.push_back(u);
+        }
+
+        return false;
+    });
+
+    trees_[v] = Free;
+}
+
+GCTS_END
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "maxFlowSolver.h"
+#include "ringQueue.h"
+
+GCTS_BEGIN
+
+// Boykov-Kolmogorov max flow. search trees are reused between augmentations
+class BKSolver : public MaxFlowSolver
+{
+public:
+
+    using Index = Graph::Index;
+
+    const MinCutResult &findMinCut(const Graph &graph) override;
+
+private:
+
+    static constexpr Index NIL = Graph::NIL;
+
+    // parent of vertices directly connected to a terminal
+    static constexpr Index TERMINAL = NIL - 1;
+
+    // deadline is checked once per so many augmentations
+    static constexpr int DEADLINE_CHECK_INTERVAL = 64;
+
+    enum Tree : std::uint8_t
+    {
+        Free,
+        SrcTree,
+        SinkTree,
+    };
+
+    static Index sister(Index arc) noexcept
+        { return Graph::getSisterArc(arc); }
+
+    Index head(Index arc) const noexcept { return graph_->getArcHead(arc); }
+
+    int res(Index arc) const noexcept
+    {
+        const Index e = arc >> 1;
+        return (arc & 1) ? capacities_[e] + flows_[e]
+                         : capacities_[e] - flows_[e];
+    }
+
+    void push(Index arc, int flow) noexcept
+        { flows_[arc >> 1] += (arc & 1) ? -flow : flow; }
+
+    void initSearchTrees();
+
+    const MinCutResult &runMaxFlow();
+
+    void activate(Index v);
+
+    // returns the arc from src tree to sink tree. NIL if not found
+    Index grow();
+
+    void augment(Index meetArc);
+
+    void adopt();
+
+    void adoptOrphan(Index v);
+
+    const Graph *graph_ = nullptr;
+
+    std::vector<int> capacities_;
+    std::vector<int> flows_;
+
+    std::vector<int> terminalRes_;
+
+    // search trees
+
+    std::vector<Tree>  trees_;
+    std::vector<Index> parents_; // arc to parent. NIL for orphans
+    std::vector<int>   timestamps_;
+    std::vector<int>   dists_;
+    Bitmap             isActive_;
+
+    RingQueue<Index> activeVtces_;
+    RingQueue<Index> orphans_;
+
+    int time_ = 0;
+};
+
+GCTS_END
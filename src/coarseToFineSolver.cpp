@@ -0,0 +1,285 @@
+#include <algorithm>
+
+#include "coarseToFineSolver.h"
+
+GCTS_BEGIN
+
+CoarseToFineSolver::CoarseToFineSolver(
+    std::unique_ptr<MaxFlowSolver> solver) noexcept
+    : solver_(std::move(solver))
+{
+
+}
+
+void CoarseToFineSolver::setDeadline(Clock::time_point deadline) noexcept
+{
+    MaxFlowSolver::setDeadline(deadline);
+    solver_->setDeadline(deadline);
+}
+
+const MinCutResult &CoarseToFineSolver::findMinCut(const Graph &graph)
+{
+    const int scale = getScale(graph);
+    if(scale == 1)
+        return solver_->findMinCut(graph);
+    return solveCoarseToFine(graph, scale);
+}
+
+int CoarseToFineSolver::getScale(const Graph &graph) noexcept
+{
+    const Index edgeCount = graph.getGridEdgeCount();
+    if(edgeCount >= 4 * MIN_GRID_EDGE_COUNT)
+        return 4;
+    if(edgeCount >= MIN_GRID_EDGE_COUNT)
+        return 2;
+    return 1;
+}
+
+const MinCutResult &CoarseToFineSolver::solveCoarseToFine(
+    const Graph &graph, int scale)
+{
+    // a coarse cut stopped early could leave the min cut out of the band
+
+    buildCoarseGraph(graph, scale);
+    solver_->setDeadline(Clock::time_point::max());
+    isBlockSrcSide_ = solver_->findMinCut(coarse_).reachableVertices;
+    solver_->setDeadline(getDeadline());
+
+    buildBand(graph);
+    buildBandGraph(graph);
+
+    MinCutResult &ret = result_;
+    ret.reachableVertices = solver_->findMinCut(band_).reachableVertices;
+
+    findCutEdges(graph, ret);
+    return ret;
+}
+
+void CoarseToFineSolver::buildCoarseGraph(const Graph &graph, int scale)
+{
+    gridWidth_    = int(graph.getGridWidth());
+    gridHeight_   = int(graph.getGridHeight());
+    scale_        = scale;
+    coarseWidth_  = (gridWidth_  + scale - 1) / scale;
+    coarseHeight_ = (gridHeight_ + scale - 1) / scale;
+
+    const Index gridCount   = graph.getGridVertexCount();
+    const Index coarseCount = Index(coarseWidth_) * coarseHeight_;
+
+    coarseCapacities_.assign(2 * coarseCount, 0);
+    hasCoarseEdges_.assign(2 * coarseCount, false);
+
+    // a & b are texel vertices. edges inside blocks are dropped
+
+    auto addCoarseEdge = [&](Index a, Index b, int capacity)
+    {
+        const Index lo = std::min(a, b), hi = std::max(a, b);
+
+        Index dir;
+        if(hi == lo + 1 && hi % gridWidth_)
+            dir = 0;
+        else if(hi == lo + Index(gridWidth_))
+            dir = coarseCount;
+        else
+            return;
+
+        const Index loBlock = getBlock(lo);
+        if(loBlock == getBlock(hi))
+            return;
+
+        hasCoarseEdges_.set(dir + loBlock);
+        coarseCapacities_[dir + loBlock] += capacity;
+    };
+
+    // seam vertex between texels a & b is replaced by t-links of a & b and
+    // an edge between them, costing the same up to rounding
+
+    auto addCoarseSeam = [&](
+        Index a, Index b, std::int64_t capA, std::int64_t capB,
+        std::int64_t seamTerminalCapacity)
+    {
+        auto getCost = [&](bool isASrcSide, bool isBSrcSide)
+        {
+            const std::int64_t onSrc =
+                (isASrcSide ? 0 : capA) + (isBSrcSide ? 0 : capB) +
+                std::max<std::int64_t>(-seamTerminalCapacity, 0);
+            const std::int64_t onSink =
+                (isASrcSide ? capA : 0) + (isBSrcSide ? capB : 0) +
+                std::max<std::int64_t>(seamTerminalCapacity, 0);
+            return std::min(onSrc, onSink);
+        };
+
+        const std::int64_t srcSrc   = getCost(true,  true);
+        const std::int64_t srcSink  = getCost(true,  false);
+        const std::int64_t sinkSrc  = getCost(false, true);
+        const std::int64_t sinkSink = getCost(false, false);
+
+        const std::int64_t capacity =
+            (srcSink + sinkSrc - srcSrc - sinkSink) / 2;
+        const std::int64_t terminalA = sinkSrc - srcSrc - capacity;
+        const std::int64_t terminalB = sinkSink - srcSrc - terminalA;
+
+        blockTerminalCapacities_[getBlock(a)] += terminalA;
+        blockTerminalCapacities_[getBlock(b)] += terminalB;
+        addCoarseEdge(a, b, int(capacity));
+    };
+
+    for(Index e = 0; e < 2 * gridCount; ++e)
+    {
+        if(graph.hasEdge(e))
+        {
+            addCoarseEdge(
+                graph.getEdgeA(e), graph.getEdgeB(e),
+                graph.getEdgeCapacity(e));
+        }
+    }
+
+    blockTerminalCapacities_.assign(coarseCount, 0);
+
+    for(Index s = gridCount; s < graph.getVertexCount(); ++s)
+    {
+        Index neighbors[2];
+        int   capacities[2];
+        int   degree = 0;
+
+        graph.forEachArc(s, [&](Index arc, Index u)
+        {
+            if(degree < 2)
+            {
+                neighbors[degree]  = u;
+                capacities[degree] = graph.getEdgeCapacity(
+                    Graph::getArcEdge(arc));
+            }
+            return ++degree > 2;
+        });
+
+        if(degree == 2 && neighbors[0] < gridCount && neighbors[1] < gridCount)
+        {
+            addCoarseSeam(
+                neighbors[0], neighbors[1], capacities[0], capacities[1],
+                graph.getTerminalCapacity(s));
+        }
+    }
+
+    hasSrcTexels_.assign(coarseCount, false);
+    hasSinkTexels_.assign(coarseCount, false);
+
+    for(Index v = 0; v < gridCount; ++v)
+    {
+        const Index block = getBlock(v);
+        if(graph.isSrc(v))
+            hasSrcTexels_.set(block);
+        else if(graph.isSink(v))
+            hasSinkTexels_.set(block);
+        else
+            blockTerminalCapacities_[block] += graph.getTerminalCapacity(v);
+    }
+
+    coarse_.clear();
+    coarse_.initGrid({ 0, 0 }, { coarseWidth_, coarseHeight_ });
+
+    const std::int64_t maxFinite = Graph::INF_CAPACITY - 1;
+
+    for(Index c = 0; c < coarseCount; ++c)
+    {
+        if(hasCoarseEdges_[c])
+            coarse_.addGridEdgeX(c, coarseCapacities_[c]);
+        if(hasCoarseEdges_[coarseCount + c])
+            coarse_.addGridEdgeY(c, coarseCapacities_[coarseCount + c]);
+
+        // blocks with both src & sink texels are left free and always put
+        // in the band
+
+        int capacity;
+        if(hasSrcTexels_[c] != hasSinkTexels_[c])
+            capacity = hasSrcTexels_[c] ? Graph::INF_CAPACITY
+                                        : -Graph::INF_CAPACITY;
+        else if(hasSrcTexels_[c])
+            capacity = 0;
+        else
+        {
+            capacity = int(std::clamp(
+                blockTerminalCapacities_[c], -maxFinite, maxFinite));
+        }
+        coarse_.setTerminalCapacity(c, capacity);
+    }
+
+    coarse_.buildAdjacency();
+}
+
+Graph::Index CoarseToFineSolver::getBlock(Index v) const noexcept
+{
+    const int x = int(v % gridWidth_), y = int(v / gridWidth_);
+    return Index(y / scale_) * coarseWidth_ + x / scale_;
+}
+
+void CoarseToFineSolver::buildBand(const Graph &graph)
+{
+    const Index gridCount = graph.getGridVertexCount();
+    isInBand_.assign(gridCount, false);
+
+    const int radius = BAND_RADIUS * scale_;
+
+    auto markAround = [&](int x, int y)
+    {
+        const int xBeg = std::max(x - radius, 0);
+        const int xEnd = std::min(x + radius + 1, gridWidth_);
+        const int yBeg = std::max(y - radius, 0);
+        const int yEnd = std::min(y + radius + 1, gridHeight_);
+
+        for(int by = yBeg; by < yEnd; ++by)
+        {
+            for(int bx = xBeg; bx < xEnd; ++bx)
+                isInBand_.set(Index(by) * gridWidth_ + bx);
+        }
+    };
+
+    for(int y = 0; y < gridHeight_; ++y)
+    {
+        for(int x = 0; x < gridWidth_; ++x)
+        {
+            const Index v     = Index(y) * gridWidth_ + x;
+            const Index block = getBlock(v);
+            const bool  side  = isBlockSrcSide_[block];
+
+            const bool isOnCut =
+                (hasSrcTexels_[block] && hasSinkTexels_[block]) ||
+                (x + 1 < gridWidth_ &&
+                 isBlockSrcSide_[getBlock(v + 1)] != side) ||
+                (y + 1 < gridHeight_ &&
+                 isBlockSrcSide_[getBlock(v + gridWidth_)] != side);
+
+            if(isOnCut)
+                markAround(x, y);
+        }
+    }
+}
+
+void CoarseToFineSolver::buildBandGraph(const Graph &graph)
+{
+    band_ = graph;
+
+    const Index gridCount = graph.getGridVertexCount();
+
+    for(Index v = 0; v < gridCount; ++v)
+    {
+        if(!isInBand_[v])
+        {
+            band_.setTerminalCapacity(
+                v, isBlockSrcSide_[getBlock(v)] ? Graph::INF_CAPACITY
+                                                : -Graph::INF_CAPACITY);
+        }
+    }
+
+    // edges between pinned texels are never cut. those of seam vertices are
+    // kept, so that costs of the seams stay in the cut
+
+    for(Index e = 0; e < 2 * gridCount; ++e)
+    {
+        if(band_.hasEdge(e) &&
+           !isInBand_[band_.getEdgeA(e)] && !isInBand_[band_.getEdgeB(e)])
+            band_.removeEdge(e);
+    }
+}
+
+GCTS_END
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "maxFlowSolver.h"
+
+GCTS_BEGIN
+
+// approximate min cut of large graphs. the cut of a downsampled graph is
+// refined at full resolution within a band around it
+class CoarseToFineSolver : public MaxFlowSolver
+{
+public:
+
+    using Index = Graph::Index;
+
+    // graphs with so many grid edges are downsampled by 2, and those with 4
+    // times as many by 4
+    static constexpr Index MIN_GRID_EDGE_COUNT = 1 << 19;
+
+    // half width of the band, in coarse texels
+    static constexpr int BAND_RADIUS = 2;
+
+    explicit CoarseToFineSolver(std::unique_ptr<MaxFlowSolver> solver) noexcept;
+
+    void setDeadline(Clock::time_point deadline) noexcept override;
+
+    const MinCutResult &findMinCut(const Graph &graph) override;
+
+private:
+
+    // 1 for small graphs
+    static int getScale(const Graph &graph) noexcept;
+
+    const MinCutResult &solveCoarseToFine(const Graph &graph, int scale);
+
+    void buildCoarseGraph(const Graph &graph, int scale);
+
+    // coarse vertex of texel vertex v
+    Index getBlock(Index v) const noexcept;
+
+    void buildBand(const Graph &graph);
+
+    void buildBandGraph(const Graph &graph);
+
+    std::unique_ptr<MaxFlowSolver> solver_;
+
+    // full & coarse grids
+
+    int gridWidth_    = 0;
+    int gridHeight_   = 0;
+    int scale_        = 1;
+    int coarseWidth_  = 0;
+    int coarseHeight_ = 0;
+
+    Graph coarse_;
+
+    std::vector<int> coarseCapacities_; // laid out as in Graph
+    Bitmap           hasCoarseEdges_;
+
+    std::vector<std::int64_t> blockTerminalCapacities_;
+    Bitmap                    hasSrcTexels_;
+    Bitmap                    hasSinkTexels_;
+
+    Bitmap isBlockSrcSide_;
+
+    // band at full resolution
+
+    Bitmap isInBand_;
+
+    Graph band_;
+};
+
+GCTS_END
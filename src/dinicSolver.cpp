@@ -0,0 +1,266 @@
+#include <algorithm>
+
+#include "dinicSolver.h"
+
+GCTS_BEGIN
+
+DinicSolver::DinicSolver(bool isScaling) noexcept
+    : isScaling_(isScaling)
+{
+
+}
+
+const MinCutResult &DinicSolver::findMinCut(const Graph &graph)
+{
+    init(graph);
+
+    int delta = isScaling_ ? getInitialDelta() : 1;
+
+    bool isComplete = true;
+    for(;;)
+    {
+        while(isComplete && buildLevels(delta))
+            isComplete = findBlockingFlow(delta);
+
+        if(!isComplete || delta == 1)
+            break;
+        delta >>= 1;
+    }
+
+    collectReachableVertices(delta);
+    findCutEdges(graph, result_);
+
+    graph_ = nullptr;
+    return result_;
+}
+
+void DinicSolver::init(const Graph &graph)
+{
+    graph_ = &graph;
+
+    const Index vtxCount  = graph.getVertexCount();
+    const Index edgeCount = graph.getEdgeCount();
+
+    // storage is kept between calls, so the arrays are refilled in one pass
+
+    arcOffsets_.resize(vtxCount + 1);
+    arcs_.clear();
+    arcs_.reserve(2 * edgeCount);
+    for(Index v = 0; v < vtxCount; ++v)
+    {
+        arcOffsets_[v] = Index(arcs_.size());
+        graph.forEachArc(v, [&](Index arc, Index)
+        {
+            arcs_.push_back(arc);
+            return false;
+        });
+    }
+    arcOffsets_[vtxCount] = Index(arcs_.size());
+
+    res_.resize(2 * edgeCount);
+    for(Index e = 0; e < edgeCount; ++e)
+    {
+        res_[2 * e]     = graph.getEdgeCapacity(e);
+        res_[2 * e + 1] = graph.getEdgeCapacity(e);
+    }
+
+    srcRes_.resize(vtxCount);
+    sinkRes_.resize(vtxCount);
+    for(Index v = 0; v < vtxCount; ++v)
+    {
+        const int capacity = graph.getTerminalCapacity(v);
+        srcRes_[v]  = std::max(capacity, 0);
+        sinkRes_[v] = std::max(-capacity, 0);
+    }
+
+    levels_.resize(vtxCount);
+    currentArcs_.resize(vtxCount);
+    augmentCount_ = 0;
+}
+
+int DinicSolver::getInitialDelta() const noexcept
+{
+    int maxCapacity = 0;
+
+    for(Index e = 0; e < graph_->getEdgeCount(); ++e)
+    {
+        if(graph_->hasEdge(e))
+            maxCapacity = std::max(maxCapacity, graph_->getEdgeCapacity(e));
+    }
+
+    for(Index v = 0; v < graph_->getVertexCount(); ++v)
+    {
+        if(!graph_->isSrc(v) && !graph_->isSink(v))
+        {
+            maxCapacity = std::max(
+                maxCapacity, std::abs(graph_->getTerminalCapacity(v)));
+        }
+    }
+
+    int delta = 1;
+    while(delta <= maxCapacity / 2)
+        delta <<= 1;
+    return delta;
+}
+
+bool DinicSolver::buildLevels(int delta)
+{
+    std::fill(levels_.begin(), levels_.end(), NIL);
+    sinkLevel_ = NIL;
+
+    queue_.clear();
+    for(Index v = 0; v < graph_->getVertexCount(); ++v)
+    {
+        if(srcRes_[v] >= delta)
+        {
+            levels_[v] = 0;
+            queue_.push_back(v);
+        }
+    }
+
+    // vertices at the level of the first one linked to sink are not expanded,
+    // as no shortest path goes through them to sink
+
+    while(!queue_.empty())
+    {
+        const Index v = queue_.front();
+        queue_.pop_front();
+
+        if(sinkRes_[v] >= delta && sinkLevel_ == NIL)
+            sinkLevel_ = levels_[v];
+
+        if(sinkLevel_ != NIL)
+            continue;
+
+        for(Index i = arcOffsets_[v]; i < arcOffsets_[v + 1]; ++i)
+        {
+            const Index arc = arcs_[i], u = head(arc);
+            if(res_[arc] >= delta && levels_[u] == NIL)
+            {
+                levels_[u] = levels_[v] + 1;
+                queue_.push_back(u);
+            }
+        }
+    }
+
+    return sinkLevel_ != NIL;
+}
+
+bool DinicSolver::findBlockingFlow(int delta)
+{
+    std::copy(arcOffsets_.begin(), arcOffsets_.end() - 1, currentArcs_.begin());
+
+    for(Index s = 0; s < graph_->getVertexCount(); ++s)
+    {
+        // s is removed from the level graph once it can't reach sink
+
+        while(levels_[s] == 0 && srcRes_[s] >= delta && augmentFrom(s, delta))
+        {
+            if(++augmentCount_ % DEADLINE_CHECK_INTERVAL == 0 &&
+               isPastDeadline())
+                return false;
+        }
+    }
+
+    return true;
+}
+
+bool DinicSolver::augmentFrom(Index s, int delta)
+{
+    path_.clear();
+
+    Index v = s;
+    for(;;)
+    {
+        if(levels_[v] == sinkLevel_ && sinkRes_[v] >= delta)
+        {
+            augment(s, v);
+            return true;
+        }
+
+        // advance along the current arc
+
+        Index &cur = currentArcs_[v];
+        const Index end = levels_[v] < sinkLevel_ ? arcOffsets_[v + 1] : cur;
+        while(cur < end)
+        {
+            const Index arc = arcs_[cur];
+            if(res_[arc] >= delta && levels_[head(arc)] == levels_[v] + 1)
+                break;
+            ++cur;
+        }
+
+        if(cur < end)
+        {
+            path_.push_back(arcs_[cur]);
+            v = head(arcs_[cur]);
+            continue;
+        }
+
+        // retreat. the current arc of the tail is skipped on the next advance
+        // as v is removed
+
+        levels_[v] = NIL;
+        if(path_.empty())
+            return false;
+
+        v = head(Graph::getSisterArc(path_.back()));
+        path_.pop_back();
+    }
+}
+
+void DinicSolver::augment(Index s, Index t) noexcept
+{
+    int flow = std::min(srcRes_[s], sinkRes_[t]);
+    for(Index arc : path_)
+        flow = std::min(flow, res_[arc]);
+
+    srcRes_[s]  -= flow;
+    sinkRes_[t] -= flow;
+
+    for(Index arc : path_)
+    {
+        res_[arc]                      -= flow;
+        res_[Graph::getSisterArc(arc)] += flow;
+    }
+}
+
+void DinicSolver::collectReachableVertices(int delta)
+{
+    MinCutResult &ret = result_;
+
+    const Index vtxCount = graph_->getVertexCount();
+    ret.reachableVertices.assign(vtxCount, false);
+
+    // sink vertices are never reachable after a max flow, and are skipped
+    // for flows stopped by the deadline
+
+    queue_.clear();
+    for(Index v = 0; v < vtxCount; ++v)
+    {
+        if(srcRes_[v] >= delta)
+        {
+            ret.reachableVertices.set(v);
+            queue_.push_back(v);
+        }
+    }
+
+    while(!queue_.empty())
+    {
+        const Index v = queue_.front();
+        queue_.pop_front();
+
+        for(Index i = arcOffsets_[v]; i < arcOffsets_[v + 1]; ++i)
+        {
+            const Index arc = arcs_[i], u = head(arc);
+            if(res_[arc] >= delta && !ret.reachableVertices[u] &&
+               !graph_->isSink(u))
+            {
+                ret.reachableVertices.set(u);
+                queue_.push_back(u);
+            }
+        }
+    }
+}
+
+GCTS_END
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "maxFlowSolver.h"
+#include "ringQueue.h"
+
+GCTS_BEGIN
+
+// Dinic's algorithm, with capacity scaling by default
+class DinicSolver : public MaxFlowSolver
+{
+public:
+
+    using Index = Graph::Index;
+
+    explicit DinicSolver(bool isScaling = true) noexcept;
+
+    const MinCutResult &findMinCut(const Graph &graph) override;
+
+private:
+
+    static constexpr Index NIL = Graph::NIL;
+
+    // deadline is checked once per so many augmentations
+    static constexpr int DEADLINE_CHECK_INTERVAL = 64;
+
+    Index head(Index arc) const noexcept { return graph_->getArcHead(arc); }
+
+    void init(const Graph &graph);
+
+    int getInitialDelta() const noexcept;
+
+    // returns whether sink is reachable
+    bool buildLevels(int delta);
+
+    // returns false if stopped by the deadline
+    bool findBlockingFlow(int delta);
+
+    // returns whether a path from s to sink is found and augmented
+    bool augmentFrom(Index s, int delta);
+
+    void augment(Index s, Index t) noexcept;
+
+    void collectReachableVertices(int delta);
+
+    bool isScaling_;
+
+    const Graph *graph_ = nullptr;
+
+    // arcs of each vertex, so that current arcs can be stored as indices
+    std::vector<Index> arcOffsets_;
+    std::vector<Index> arcs_;
+
+    std::vector<int> res_;     // indexed by arc
+    std::vector<int> srcRes_;  // src -> v
+    std::vector<int> sinkRes_; // v -> sink
+
+    // level graph. NIL for unreached & removed vertices
+
+    std::vector<Index> levels_;
+    Index              sinkLevel_ = NIL; // of vertices linked to sink
+
+    RingQueue<Index> queue_;
+
+    // blocking flow
+
+    std::vector<Index> currentArcs_;
+    std::vector<Index> path_;
+    int                augmentCount_ = 0;
+};
+
+GCTS_END
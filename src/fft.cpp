@@ -0,0 +1,114 @@
+#include <cassert>
+#include <cmath>
+
+#include "fft.h"
+
+GCTS_BEGIN
+
+int FFT2D::ceilPowerOf2(int x) noexcept
+{
+    int ret = 1;
+    while(ret < x)
+        ret <<= 1;
+    return ret;
+}
+
+FFT2D::FFT2D(int width, int height)
+    : width_(width), height_(height),
+      rowPlan_(createPlan(width)), colPlan_(createPlan(height)),
+      column_(height)
+{
+
+}
+
+void FFT2D::forward(Complex *data)
+{
+    transform2D(data, false);
+}
+
+void FFT2D::inverse(Complex *data)
+{
+    transform2D(data, true);
+
+    const double scale = 1.0 / (double(width_) * height_);
+    for(int i = 0; i < width_ * height_; ++i)
+        data[i] *= scale;
+}
+
+FFT2D::Plan FFT2D::createPlan(int n)
+{
+    assert(n > 0 && !(n & (n - 1)));
+
+    const double pi = 3.14159265358979323846;
+
+    Plan plan;
+
+    plan.twiddles.resize(n / 2);
+    for(int k = 0; k < n / 2; ++k)
+        plan.twiddles[k] = std::polar(1.0, -2 * pi * k / n);
+
+    plan.bitReversed.resize(n);
+    for(int i = 0, j = 0; i < n; ++i)
+    {
+        plan.bitReversed[i] = j;
+
+        int bit = n >> 1;
+        for(; j & bit; bit >>= 1)
+            j ^= bit;
+        j |= bit;
+    }
+
+    return plan;
+}
+
+void FFT2D::transform(Complex *data, const Plan &plan, bool inverse)
+{
+    const int n = static_cast<int>(plan.bitReversed.size());
+
+    for(int i = 0; i < n; ++i)
+    {
+        const int j = plan.bitReversed[i];
+        if(i < j)
+            std::swap(data[i], data[j]);
+    }
+
+    for(int len = 2; len <= n; len <<= 1)
+    {
+        const int half = len / 2;
+        const int step = n / len;
+
+        for(int i = 0; i < n; i += len)
+        {
+            for(int j = 0; j < half; ++j)
+            {
+                const Complex w = inverse ? std::conj(plan.twiddles[j * step])
+                                          : plan.twiddles[j * step];
+                const Complex u = data[i + j];
+                const Complex v = data[i + j + half] * w;
+                data[i + j]        = u + v;
+                data[i + j + half] = u - v;
+            }
+        }
+    }
+}
+
+void FFT2D::transform2D(Complex *data, bool inverse)
+{
+    for(int y = 0; y < height_; ++y)
+        transform(data + y * width_, rowPlan_, inverse);
+
+    // columns are gathered into a contiguous buffer
+
+    for(int x = 0; x < width_; ++x)
+    {
+        for(int y = 0; y < height_; ++y)
+            column_[y] = data[y * width_ + x];
+
+        transform(column_.data(), colPlan_, inverse);
+
+        for(int y = 0; y < height_; ++y)
+            data[y * width_ + x] = column_[y];
+    }
+}
+
+GCTS_END
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <complex>
+#include <vector>
+
+#include "synthesizer.h"
+
+GCTS_BEGIN
+
+/*
+ * iterative radix-2 fft of row-major 2d arrays
+ */
+class FFT2D
+{
+public:
+
+    using Complex = std::complex<double>;
+
+    static int ceilPowerOf2(int x) noexcept;
+
+    // width & height must be powers of 2
+    FFT2D(int width, int height);
+
+    int getWidth () const noexcept { return width_;  }
+    int getHeight() const noexcept { return height_; }
+
+    void forward(Complex *data);
+
+    // result is scaled by 1 / (width * height)
+    void inverse(Complex *data);
+
+private:
+
+    struct Plan
+    {
+        std::vector<Complex> twiddles; // exp(-2pi i k / n), k < n / 2
+        std::vector<int>     bitReversed;
+    };
+
+    static Plan createPlan(int n);
+
+    static void transform(Complex *data, const Plan &plan, bool inverse);
+
+    void transform2D(Complex *data, bool inverse);
+
+    int width_;
+    int height_;
+
+    Plan rowPlan_;
+    Plan colPlan_;
+
+    std::vector<Complex> column_;
+};
+
+GCTS_END
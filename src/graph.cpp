@@ -1,184 +1,141 @@
-#include <queue>
-
 #include "graph.h"
 
 GCTS_BEGIN
 
-Graph::Graph(std::set<Vertex *> allVertices) noexcept
-    : vtces_(std::move(allVertices))
+void Graph::clear() noexcept
 {
-    for(auto v : vtces_)
-    {
-        if(v->isSrc)
-            srcs_.insert(v);
-    }
-}
+    gridBeg_    = Int2();
+    gridWidth_  = 0;
+    gridHeight_ = 0;
+    gridCount_  = 0;
 
-Graph::MinCutResult Graph::findMinCut()
-{
-    // find max flow
+    gridEdgeCount_ = 0;
 
-    for(auto v : vtces_)
-    {
-        for(auto e : v->edges)
-        {
-            if(e)
-                e->a2bFlow = 0;
-        }
-    }
+    extraVtxTypes_.clear();
+    extraVtxPositions_.clear();
 
-    while(runMaxFlowIteration())
-        ; // do nothing
+    extraEdgeAs_.clear();
+    extraEdgeBs_.clear();
 
-    // run bfs on res graph
+    extraAdjOffsets_.clear();
+    extraAdjArcs_.clear();
 
-    for(auto v : vtces_)
-        v->bfsAccesser = nullptr;
+    terminalCapacities_.clear();
 
-    std::queue<Vertex *> vtxQueue;
-    for(auto v : srcs_)
-        vtxQueue.push(v);
+    edges_.clear();
+    capacities_.clear();
+}
 
-    while(!vtxQueue.empty())
-    {
-        auto v = vtxQueue.front();
-        vtxQueue.pop();
-
-        for(auto e : v->edges)
-        {
-            if(!e)
-                continue;
-
-            if(v == e->a)
-            {
-                if(!e->b->isSrc && !e->b->bfsAccesser && e->a2bRes() > 0)
-                {
-                    e->b->bfsAccesser = e;
-                    vtxQueue.push(e->b);
-                }
-            }
-            else
-            {
-                if(!e->a->isSrc && !e->a->bfsAccesser && e->b2aRes() > 0)
-                {
-                    e->a->bfsAccesser = e;
-                    vtxQueue.push(e->a);
-                }
-            }
-        }
-    }
+void Graph::initGrid(const Int2 &gridBeg, const Int2 &gridSize)
+{
+    assert(!getVertexCount());
 
-    // find reachable boundary
+    gridBeg_    = gridBeg;
+    gridWidth_  = Index(gridSize.x);
+    gridHeight_ = Index(gridSize.y);
+    gridCount_  = gridWidth_ * gridHeight_;
 
-    MinCutResult ret;
+    gridEdgeCount_ = 0;
 
-    const auto isReachable = [](const Vertex *v)
-    {
-        return v->isSrc || v->bfsAccesser;
-    };
+    edges_.assign(2 * gridCount_, false);
+    capacities_.assign(2 * gridCount_, 0);
 
-    for(auto v : vtces_)
-    {
-        if(!isReachable(v))
-            continue;
+    terminalCapacities_.assign(gridCount_, 0);
+}
 
-        ret.reachableVertices.insert(v);
+Graph::Index Graph::getTexelVertex(const Int2 &position) const noexcept
+{
+    const Int2 local = position - gridBeg_;
+    assert(0 <= local.x && Index(local.x) < gridWidth_);
+    assert(0 <= local.y && Index(local.y) < gridHeight_);
+    return Index(local.y) * gridWidth_ + Index(local.x);
+}
 
-        for(auto e : v->edges)
-        {
-            if(e && !isReachable(e->another(v)))
-                ret.cut.insert(e);
-        }
-    }
+void Graph::addGridEdgeX(Index c, int capacity) noexcept
+{
+    assert(c % gridWidth_ != gridWidth_ - 1);
+    gridEdgeCount_ += !edges_[c];
+    edges_.set(c);
+    capacities_[c] = capacity;
+}
 
-    return ret;
+void Graph::addGridEdgeY(Index c, int capacity) noexcept
+{
+    assert(c + gridWidth_ < gridCount_);
+    gridEdgeCount_ += !edges_[gridCount_ + c];
+    edges_.set(gridCount_ + c);
+    capacities_[gridCount_ + c] = capacity;
 }
 
-int Graph::runMaxFlowIteration()
+Graph::Index Graph::addVertex(VertexType type, const Int2 &position)
 {
-    // run bfs to find a res path
+    const Index v = getVertexCount();
 
-    for(auto v : vtces_)
-        v->bfsAccesser = nullptr;
+    extraVtxTypes_.push_back(type);
+    extraVtxPositions_.push_back(position);
 
-    std::queue<Vertex *> vtxQueue;
-    for(auto v : srcs_)
-        vtxQueue.push(v);
+    terminalCapacities_.push_back(0);
 
-    Vertex *v = nullptr;
-    while(!vtxQueue.empty())
+    return v;
+}
+
+Graph::Index Graph::addEdge(Index a, Index b, int capacity)
+{
+    const Index e = getEdgeCount();
+
+    extraEdgeAs_.push_back(a);
+    extraEdgeBs_.push_back(b);
+    capacities_.push_back(capacity);
+
+    edges_.resize(e + 1);
+    edges_.set(e);
+
+    return e;
+}
+
+void Graph::buildAdjacency()
+{
+    const Index vtxCount       = getVertexCount();
+    const Index extraEdgeCount = Index(extraEdgeAs_.size());
+    const Index extraEdgeBeg   = 2 * gridCount_;
+
+    extraAdjOffsets_.assign(vtxCount + 1, 0);
+    for(Index i = 0; i < extraEdgeCount; ++i)
     {
-        v = vtxQueue.front();
-        vtxQueue.pop();
-
-        if(v->isSink)
-            break;
-
-        for(auto e : v->edges)
-        {
-            if(!e)
-                continue;
-
-            if(v == e->a)
-            {
-                if(!e->b->isSrc && !e->b->bfsAccesser && e->a2bRes() > 0)
-                {
-                    e->b->bfsAccesser = e;
-                    vtxQueue.push(e->b);
-                }
-            }
-            else
-            {
-                if(!e->a->isSrc && !e->a->bfsAccesser && e->b2aRes() > 0)
-                {
-                    e->a->bfsAccesser = e;
-                    vtxQueue.push(e->a);
-                }
-            }
-        }
-
-        v = nullptr;
+        ++extraAdjOffsets_[extraEdgeAs_[i] + 1];
+        ++extraAdjOffsets_[extraEdgeBs_[i] + 1];
     }
 
-    if(!v)
-        return 0;
+    for(Index v = 0; v < vtxCount; ++v)
+        extraAdjOffsets_[v + 1] += extraAdjOffsets_[v];
 
-    // find capacity of the path
+    auto &fillPos = extraAdjFillPos_;
+    fillPos.assign(extraAdjOffsets_.begin(), extraAdjOffsets_.end() - 1);
 
-    int pathRes = std::numeric_limits<int>::max();
-    for(auto tv = v; !tv->isSrc;)
+    extraAdjArcs_.resize(2 * extraEdgeCount);
+    for(Index i = 0; i < extraEdgeCount; ++i)
     {
-        Edge *e = tv->bfsAccesser;
-        if(tv == e->a)
-        {
-            pathRes = std::min(pathRes, e->b2aRes());
-            tv = e->b;
-        }
-        else
-        {
-            pathRes = std::min(pathRes, e->a2bRes());
-            tv = e->a;
-        }
+        const Index e = extraEdgeBeg + i;
+        extraAdjArcs_[fillPos[extraEdgeAs_[i]]++] = 2 * e;
+        extraAdjArcs_[fillPos[extraEdgeBs_[i]]++] = 2 * e + 1;
     }
+}
 
-    // update edge flow
+Graph::VertexType Graph::getVertexType(Index v) const noexcept
+{
+    return v < gridCount_ ? VertexType::Texel
+                          : extraVtxTypes_[v - gridCount_];
+}
 
-    for(auto tv = v; !tv->isSrc;)
+Int2 Graph::getVertexPosition(Index v) const noexcept
+{
+    if(v < gridCount_)
     {
-        Edge *e = tv->bfsAccesser;
-        if(tv == e->a)
-        {
-            e->a2bFlow -= pathRes;
-            tv = e->b;
-        }
-        else
-        {
-            e->a2bFlow += pathRes;
-            tv = e->a;
-        }
+        return gridBeg_ + Int2(
+            static_cast<int>(v % gridWidth_),
+            static_cast<int>(v / gridWidth_));
     }
-
-    return pathRes;
+    return extraVtxPositions_[v - gridCount_];
 }
 
 GCTS_END
@@ -1,76 +1,227 @@
 #pragma once
 
-#include <array>
-#include <set>
+#include <cstdint>
+#include <limits>
+#include <vector>
 
-#include "synthesizer.h"
+#include "bitmap.h"
 
 GCTS_BEGIN
 
-struct Edge;
-
-struct Vertex
+/*
+ * vertices and edges are identified by 32-bit indices and stored in
+ * struct-of-arrays form.
+ *
+ * texel vertices form a dense grid covering the bounding box of the overlap
+ * region. vertex c < G = gridWidth * gridHeight is the texel at
+ * gridBeg + (c % gridWidth, c / gridWidth), and its neighbors are addressed
+ * by offset arithmetic. grid cells out of the overlap region are isolated
+ * vertices. edges between neighboring texels are never materialized:
+ *
+ *   edge c     in [0, G)  connects texel c and c + 1         (+x direction)
+ *   edge G + c in [G, 2G) connects texel c and c + gridWidth (+y direction)
+ *
+ * and their capacities are stored in dense per-direction arrays.
+ *
+ * seam vertices and edges connecting them are rare, so they are appended
+ * after the grid part as a sparse side table with CSR adjacency.
+ *
+ * each (undirected) edge e connects a = edgeA(e) and b = edgeB(e) and has two
+ * arcs: 2 * e (a -> b) and 2 * e + 1 (b -> a).
+ *
+ * there is a single src terminal and a single sink terminal. each vertex v
+ * has one terminal edge (t-link) with signed capacity c: src -> v with
+ * capacity c if c > 0, and v -> sink with capacity -c if c < 0. a vertex
+ * linked to both terminals only keeps the difference, which shifts the cost
+ * of every cut by the same constant. src/sink vertices, which must end on
+ * the src/sink side of the cut, have t-links of +/-INF_CAPACITY.
+ *
+ * min cuts are computed by MaxFlowSolver implementations.
+ */
+class Graph
 {
-    enum Type
+public:
+
+    using Index = std::uint32_t;
+
+    static constexpr Index NIL = std::numeric_limits<Index>::max();
+
+    static constexpr int INF_CAPACITY = std::numeric_limits<int>::max() / 2;
+
+    enum class VertexType : std::uint8_t
     {
-        DummySrc,
         Texel,
         HoriSeam,
         VertSeam,
     };
 
-    bool isSrc  = false;
-    bool isSink = false;
+    // construction
 
-    Edge *bfsAccesser = nullptr;
+    // remove all vertices & edges. storage is kept for reuse
+    void clear() noexcept;
 
-    Type type = Texel;
-    Int2 position;
+    void initGrid(const Int2 &gridBeg, const Int2 &gridSize);
 
-    static constexpr int EDGE_POS_X = 0;
-    static constexpr int EDGE_NEG_X = 1;
-    static constexpr int EDGE_POS_Y = 2;
-    static constexpr int EDGE_NEG_Y = 3;
-    static constexpr int EDGE_HORI_SEAM_TO_SRC = 2;
-    static constexpr int EDGE_VERT_SEAM_TO_SRC = 0;
+    Index getTexelVertex(const Int2 &position) const noexcept;
 
-    std::array<Edge *, 4> edges = { nullptr, nullptr, nullptr, nullptr };
-};
+    // edge between texel vertex c and c + 1
+    void addGridEdgeX(Index c, int capacity) noexcept;
 
-struct Edge
-{
-    Vertex *a = nullptr;
-    Vertex *b = nullptr;
+    // edge between texel vertex c and c + gridWidth
+    void addGridEdgeY(Index c, int capacity) noexcept;
+
+    Index addVertex(VertexType type, const Int2 &position);
+
+    Index addEdge(Index a, Index b, int capacity);
+
+    void setTerminalCapacity(Index v, int capacity) noexcept
+        { terminalCapacities_[v] = capacity; }
+
+    // must be called after all vertices/edges are added
+    void buildAdjacency();
+
+    // vertices
+
+    Index getVertexCount() const noexcept
+        { return gridCount_ + Index(extraVtxTypes_.size()); }
+
+    // texel vertices are [0, getGridVertexCount())
+    Index getGridVertexCount() const noexcept { return gridCount_; }
+
+    Index getGridWidth () const noexcept { return gridWidth_;  }
+    Index getGridHeight() const noexcept { return gridHeight_; }
+
+    VertexType getVertexType(Index v) const noexcept;
+
+    Int2 getVertexPosition(Index v) const noexcept;
+
+    int getTerminalCapacity(Index v) const noexcept
+        { return terminalCapacities_[v]; }
+
+    bool isSrc (Index v) const noexcept
+        { return terminalCapacities_[v] >= INF_CAPACITY; }
+    bool isSink(Index v) const noexcept
+        { return terminalCapacities_[v] <= -INF_CAPACITY; }
+
+    // edges
+
+    Index getEdgeCount() const noexcept { return Index(capacities_.size()); }
+
+    Index getEdgeA(Index e) const noexcept;
+    Index getEdgeB(Index e) const noexcept;
+
+    int getEdgeCapacity(Index e) const noexcept { return capacities_[e]; }
+
+    // grid edges between texels out of overlap region don't exist, nor do
+    // removed edges
+    bool hasEdge(Index e) const noexcept { return edges_[e]; }
+
+    // the edge index stays valid, and the adjacency needs not be rebuilt
+    void removeEdge(Index e) noexcept;
 
-    int capacity = 0;
-    int a2bFlow  = 0;
+    // existing edges in [0, 2G)
+    Index getGridEdgeCount() const noexcept { return gridEdgeCount_; }
 
-    int a2bRes() const noexcept { return capacity - a2bFlow; }
-    int b2aRes() const noexcept { return capacity + a2bFlow; }
+    // arcs
 
-    Vertex *another(const Vertex *v) noexcept { return v == a ? b : a; }
+    static Index getArcEdge(Index arc) noexcept { return arc >> 1; }
+
+    static Index getSisterArc(Index arc) noexcept { return arc ^ 1; }
+
+    Index getArcHead(Index arc) const noexcept
+        { return (arc & 1) ? getEdgeA(arc >> 1) : getEdgeB(arc >> 1); }
+
+    // func(arc, head) is called for each arc leaving v.
+    // iteration stops when func returns true
+    template<typename Func>
+    bool forEachArc(Index v, Func &&func) const;
+
+private:
+
+    // grid part
+
+    Int2  gridBeg_;
+    Index gridWidth_  = 0;
+    Index gridHeight_ = 0;
+    Index gridCount_  = 0;
+
+    Index gridEdgeCount_ = 0;
+
+    // sparse part
+
+    std::vector<VertexType> extraVtxTypes_;
+    std::vector<Int2>       extraVtxPositions_;
+
+    std::vector<Index> extraEdgeAs_;
+    std::vector<Index> extraEdgeBs_;
+
+    std::vector<Index> extraAdjOffsets_;
+    std::vector<Index> extraAdjArcs_;
+    std::vector<Index> extraAdjFillPos_; // scratch of buildAdjacency
+
+    // shared by both parts
+
+    std::vector<int> terminalCapacities_; // indexed by vertex
+
+    Bitmap edges_; // existence of edges
+
+    std::vector<int> capacities_;
 };
 
-class Graph
+inline Graph::Index Graph::getEdgeA(Index e) const noexcept
 {
-public:
+    if(e < gridCount_)
+        return e;
+    if(e < 2 * gridCount_)
+        return e - gridCount_;
+    return extraEdgeAs_[e - 2 * gridCount_];
+}
+
+inline Graph::Index Graph::getEdgeB(Index e) const noexcept
+{
+    if(e < gridCount_)
+        return e + 1;
+    if(e < 2 * gridCount_)
+        return e - gridCount_ + gridWidth_;
+    return extraEdgeBs_[e - 2 * gridCount_];
+}
+
+inline void Graph::removeEdge(Index e) noexcept
+{
+    if(e < 2 * gridCount_)
+        gridEdgeCount_ -= edges_[e];
+    edges_.reset(e);
+}
 
-    struct MinCutResult
+template<typename Func>
+bool Graph::forEachArc(Index v, Func &&func) const
+{
+    if(v < gridCount_)
     {
-        std::set<Vertex *> reachableVertices;
-        std::set<Edge *> cut;
-    };
+        const Index ex = v, ey = gridCount_ + v;
 
-    explicit Graph(std::set<Vertex *> allVertices) noexcept;
+        if(edges_[ex] && func(2 * ex, v + 1))
+            return true;
 
-    MinCutResult findMinCut();
+        if(v >= 1 && edges_[ex - 1] && func(2 * (ex - 1) + 1, v - 1))
+            return true;
 
-private:
+        if(edges_[ey] && func(2 * ey, v + gridWidth_))
+            return true;
 
-    int runMaxFlowIteration();
+        if(v >= gridWidth_ && edges_[ey - gridWidth_] &&
+           func(2 * (ey - gridWidth_) + 1, v - gridWidth_))
+            return true;
+    }
 
-    std::set<Vertex *> vtces_;
-    std::set<Vertex *> srcs_;
-};
+    for(Index i = extraAdjOffsets_[v]; i < extraAdjOffsets_[v + 1]; ++i)
+    {
+        const Index arc = extraAdjArcs_[i];
+        if(edges_[arc >> 1] && func(arc, getArcHead(arc)))
+            return true;
+    }
+
+    return false;
+}
 
 GCTS_END
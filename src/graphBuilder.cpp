@@ -1,100 +1,125 @@
+#ifdef AGZ_UTILS_SSE
+#include <emmintrin.h>
+#endif
+
 #include "graphBuilder.h"
 
 GCTS_BEGIN
 
-Graph GraphBuilder::build(
-    Image2D<Texel>         &texels,
+void GraphBuilder::build(
+    const TexelPlanes      &texels,
     const ImageView2D<RGB> &patch,
+    int                     patchIndex,
     const Int2             &patchBeg,
     const Int2             &patchOverlapSize,
-    const PatchHistory     &patchHistory)
+    const PatchHistory     &patchHistory,
+    Graph                  &graph)
 {
-    // clear texel vertices
+    // only texels strictly inside the patch can be New or Overlap, so the
+    // window is the patch clipped by the image
+
+    const Int2 patchEnd = patchBeg + patch.size();
+
+    patch_      = &patch;
+    patchIndex_ = patchIndex;
+    patchBeg_   = patchBeg;
 
-    for(int y = 0; y < texels.height(); ++y)
+    graph_ = &graph;
+    graph_->clear();
+
+    newTexels_.clear();
+
+    windowBeg_ = { std::max(patchBeg.x, 0), std::max(patchBeg.y, 0) };
+    windowEnd_ = {
+        std::min(patchEnd.x, texels.width()),
+        std::min(patchEnd.y, texels.height())
+    };
+
+    if(windowBeg_.x >= windowEnd_.x || windowBeg_.y >= windowEnd_.y)
     {
-        for(int x = 0; x < texels.width(); ++x)
-        {
-            auto &t = texels(y, x);
-            t.texelVertex          = {};
-            t.texelVertex.position = { x, y };
-        }
+        graph_->initGrid({ 0, 0 }, { 0, 0 });
+        graph_->buildAdjacency();
+        return;
     }
 
-    const auto regions = buildRegionDistribution(
-        texels, patch, patchBeg, patchOverlapSize);
+    buildRegionDistribution(texels, patch, patchBeg, patchOverlapSize);
+
+    // texel vertices
 
-    for(int y = 0; y < texels.height(); ++y)
+    initGrid();
+    computeGridEdgeCapacities(texels, patchHistory);
+
+    for(int y = windowBeg_.y; y < windowEnd_.y; ++y)
     {
-        for(int x = 0; x < texels.width(); ++x)
+        for(int x = windowBeg_.x; x < windowEnd_.x; ++x)
         {
-            if(regions(y, x) == Region::New)
-                texels(y, x).patchIndex = patchHistory.getCurrentIndex();
+            if(getRegion(y - windowBeg_.y, x - windowBeg_.x) == Region::New)
+                newTexels_.push_back({ x, y });
         }
     }
 
-    // create vertices and edges
-
-    std::set<Vertex *> allVertices;
+    // create vertices and edges. the last row/column of the window is either
+    // out of the patch interior or on the image border
 
-    for(int y = 0; y < texels.height() - 1; ++y)
+    for(int y = windowBeg_.y; y < windowEnd_.y - 1; ++y)
     {
-        for(int x = 0; x < texels.width() - 1; ++x)
+        for(int x = windowBeg_.x; x < windowEnd_.x - 1; ++x)
         {
-            const Region cenRegion = regions(y, x);
-            const Region xPosRegion = regions(y, x + 1);
-            const Region yPosRegion = regions(y + 1, x);
+            const int lx = x - windowBeg_.x, ly = y - windowBeg_.y;
 
-            Texel &cenTexel = texels(y, x);
-            Texel &xPosTexel = texels(y, x + 1);
-            Texel &yPosTexel = texels(y + 1, x);
+            const Region cenRegion = getRegion(ly, lx);
+            const Region xPosRegion = getRegion(ly, lx + 1);
+            const Region yPosRegion = getRegion(ly + 1, lx);
+
+            const Texel cenTexel = texels(y, x);
+            const Texel xPosTexel = texels(y, x + 1);
+            const Texel yPosTexel = texels(y + 1, x);
 
             handleNeighbors(
-                allVertices,
                 { x,     y }, cenTexel, cenRegion,
                 { x + 1, y }, xPosTexel, xPosRegion,
                 patchHistory);
 
             handleNeighbors(
-                allVertices,
                 { x, y     }, cenTexel, cenRegion,
                 { x, y + 1 }, yPosTexel, yPosRegion,
                 patchHistory);
         }
     }
 
-    // a vertex cannot be 'src' and 'sink' simultaneously
+    graph_->buildAdjacency();
+}
 
-    for(auto v : allVertices)
-    {
-        if(v->isSrc && v->isSink)
-            v->isSrc = false;
-    }
+const std::vector<Int2> &GraphBuilder::getNewTexels() const noexcept
+{
+    return newTexels_;
+}
 
-    return Graph(allVertices);
+GraphBuilder::Region &GraphBuilder::getRegion(int ly, int lx) noexcept
+{
+    return regions_[size_t(ly) * (windowEnd_.x - windowBeg_.x) + lx];
 }
 
-Image2D<GraphBuilder::Region> GraphBuilder::buildRegionDistribution(
-    Image2D<Texel>         &texels,
+void GraphBuilder::buildRegionDistribution(
+    const TexelPlanes      &texels,
     const ImageView2D<RGB> &patch,
     const Int2             &patchBeg,
-    const Int2             &patchOverlapSize) const
+    const Int2             &patchOverlapSize)
 {
-    Image2D<Region> regions(
-        texels.height(), texels.width());
+    regions_.resize(
+        size_t(windowEnd_.x - windowBeg_.x) * (windowEnd_.y - windowBeg_.y));
 
     const Int2 patchEnd = patchBeg + patch.size();
 
     bool hasNew = false;
 
-    for(int y = 0; y < texels.height(); ++y)
+    for(int y = windowBeg_.y; y < windowEnd_.y; ++y)
     {
-        for(int x = 0; x < texels.width(); ++x)
+        for(int x = windowBeg_.x; x < windowEnd_.x; ++x)
         {
-            auto &texel = texels(y, x);
-            auto &region = regions(y, x);
+            auto &region = getRegion(y - windowBeg_.y, x - windowBeg_.x);
 
-            const bool coveredByOldPatch = texel.patchIndex >= 0;
+            const bool coveredByOldPatch = texels.getPatchIndex(y, x) >= 0;
             const bool coveredByNewPatch =
                 patchBeg.x < x && x < patchEnd.x - 1 &&
                 patchBeg.y < y && y < patchEnd.y - 1;
@@ -110,16 +135,16 @@ Image2D<GraphBuilder::Region> GraphBuilder::buildRegionDistribution(
     }
 
     if(hasNew)
-        return regions;
+        return;
 
     const Int2 patchCoreBeg = patchBeg + patchOverlapSize;
     const Int2 patchCoreEnd = patchEnd - patchOverlapSize;
 
-    for(int y = 0; y < texels.height(); ++y)
+    for(int y = windowBeg_.y; y < windowEnd_.y; ++y)
     {
-        for(int x = 0; x < texels.width(); ++x)
+        for(int x = windowBeg_.x; x < windowEnd_.x; ++x)
         {
-            auto &region = regions(y, x);
+            auto &region = getRegion(y - windowBeg_.y, x - windowBeg_.x);
 
             const bool coveredByNewCore =
                 patchCoreBeg.x <= x && x < patchCoreEnd.x &&
@@ -129,13 +154,11 @@ Image2D<GraphBuilder::Region> GraphBuilder::buildRegionDistribution(
                 region = Region::New;
         }
     }
-
-    return regions;
 }
 
 int GraphBuilder::computeSeamCost(
     const RGB &As, const RGB &At,
-    const RGB &Bs, const RGB &Bt) const
+    const RGB &Bs, const RGB &Bt) noexcept
 {
     const int diffs = std::abs(As.r - Bs.r)
                     + std::abs(As.g - Bs.g)
@@ -146,204 +169,283 @@ int GraphBuilder::computeSeamCost(
     return diffs + difft;
 }
 
+const RGB &GraphBuilder::getRGB(
+    int patchIndex, const Int2 &position,
+    const PatchHistory &patches) const noexcept
+{
+    if(patchIndex == patchIndex_)
+    {
+        const Int2 localPos = position - patchBeg_;
+        return (*patch_)(localPos.y, localPos.x);
+    }
+    return patches.getRGB(patchIndex, position.x, position.y);
+}
+
 int GraphBuilder::computeSeamCost(
     int AIndex, int BIndex,
     const Int2 &s, const Int2 &t,
     const PatchHistory &patches) const
 {
-    const RGB As = patches.getRGB(AIndex, s.x, s.y);
-    const RGB At = patches.getRGB(AIndex, t.x, t.y);
-    const RGB Bs = patches.getRGB(BIndex, s.x, s.y);
-    const RGB Bt = patches.getRGB(BIndex, t.x, t.y);
+    const RGB As = getRGB(AIndex, s, patches);
+    const RGB At = getRGB(AIndex, t, patches);
+    const RGB Bs = getRGB(BIndex, s, patches);
+    const RGB Bt = getRGB(BIndex, t, patches);
     return computeSeamCost(As, At, Bs, Bt);
 }
 
-int GraphBuilder::computeSeamCost(
-    int AIndex, int BIndex, int CIndex,
-    const Int2 &s, const Int2 &t,
-    const PatchHistory &patches) const
+uint32_t GraphBuilder::packRGB(const RGB &color) noexcept
 {
-    const RGB As = patches.getRGB(AIndex, s.x, s.y);
-    const RGB Bt = patches.getRGB(BIndex, t.x, t.y);
-    const RGB Cs = patches.getRGB(CIndex, s.x, s.y);
-    const RGB Ct = patches.getRGB(CIndex, t.x, t.y);
-    return computeSeamCost(As, Bt, Cs, Ct);
+    return uint32_t(color.r) | (uint32_t(color.g) << 8) |
+           (uint32_t(color.b) << 16);
 }
 
-std::pair<Vertex *, Vertex*> GraphBuilder::addSeam(
-    const Int2 &aPos, Texel &aTexel, Vertex *aVertex,
-    const Int2 &bPos, Texel &bTexel, Vertex *bVertex,
-    int seamCost, Vertex::Type seamVertexType,
-    const PatchHistory &patches)
+void GraphBuilder::computeColorDiffs(
+    const uint32_t *a, const uint32_t *b, int *diffs, int count) noexcept
 {
-    Vertex *seamVertex = vertexArena_.create();
-    Vertex *seamSrc    = vertexArena_.create();
+    int i = 0;
 
-    Edge *seamSrcEdge = edgeArena_.create();
-    Edge *a2Seam      = edgeArena_.create();
-    Edge *b2Seam      = edgeArena_.create();
+#ifdef AGZ_UTILS_SSE
 
-    const int a2SeamCost = computeSeamCost(
-        aTexel.patchIndex, patches.getCurrentIndex(),
-        aPos, bPos, patches);
-    const int b2SeamCost = computeSeamCost(
-        bTexel.patchIndex, patches.getCurrentIndex(),
-        aPos, bPos, patches);
+    // |a - b| per byte, then bytes of each pixel are summed in two steps
+
+    const __m128i lowBytes = _mm_set1_epi16(0x00ff);
+    const __m128i lowWords = _mm_set1_epi32(0x0000ffff);
 
-    seamSrcEdge->a = seamVertex;
-    seamSrcEdge->b = seamSrc;
-    a2Seam->a = aVertex;
-    a2Seam->b = seamVertex;
-    b2Seam->a = bVertex;
-    b2Seam->b = seamVertex;
+    for(; i + 4 <= count; i += 4)
+    {
+        const __m128i va = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(a + i));
+        const __m128i vb = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(b + i));
+
+        const __m128i byteDiffs = _mm_or_si128(
+            _mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
 
-    seamSrcEdge->capacity = seamCost;
-    a2Seam->capacity = a2SeamCost;
-    b2Seam->capacity = b2SeamCost;
+        const __m128i wordSums = _mm_add_epi16(
+            _mm_and_si128(byteDiffs, lowBytes), _mm_srli_epi16(byteDiffs, 8));
+        const __m128i pixelSums = _mm_add_epi32(
+            _mm_and_si128(wordSums, lowWords), _mm_srli_epi32(wordSums, 16));
 
-    seamVertex->position = aPos;
-    seamVertex->type     = seamVertexType;
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(diffs + i), pixelSums);
+    }
 
-    seamSrc->type     = Vertex::Type::DummySrc;
-    seamSrc->position = aPos;
-    seamSrc->isSrc    = true;
-    seamSrc->edges[0] = seamSrcEdge;
+#endif
 
-    if(seamVertexType == Vertex::Type::HoriSeam)
+    for(; i < count; ++i)
     {
-        aVertex->edges[Vertex::EDGE_POS_X] = a2Seam;
-        seamVertex->edges[Vertex::EDGE_NEG_X] = a2Seam;
+        int diff = 0;
+        for(int shift = 0; shift < 24; shift += 8)
+        {
+            diff += std::abs(
+                int((a[i] >> shift) & 0xff) - int((b[i] >> shift) & 0xff));
+        }
+        diffs[i] = diff;
+    }
+}
 
-        bVertex->edges[Vertex::EDGE_NEG_X] = b2Seam;
-        seamVertex->edges[Vertex::EDGE_POS_X] = b2Seam;
+void GraphBuilder::addShifted(
+    const int *diffs, int shift, int *sums, int count) noexcept
+{
+    int i = 0;
 
-        seamVertex->edges[Vertex::EDGE_HORI_SEAM_TO_SRC] = seamSrcEdge;
+#ifdef AGZ_UTILS_SSE
+
+    for(; i + 4 <= count; i += 4)
+    {
+        const __m128i lhs = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(diffs + i));
+        const __m128i rhs = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(diffs + i + shift));
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(sums + i), _mm_add_epi32(lhs, rhs));
     }
-    else
+
+#endif
+
+    for(; i < count; ++i)
+        sums[i] = diffs[i] + diffs[i + shift];
+}
+
+void GraphBuilder::computeGridEdgeCapacities(
+    const TexelPlanes &texels, const PatchHistory &patches)
+{
+    // edge cost is |old(s) - new(s)| + |old(t) - new(t)|. per-texel terms
+    // are computed once per row
+
+    const int gridWidth  = gridSize_.x;
+    const int gridHeight = gridSize_.y;
+    const size_t gridCount = size_t(gridWidth) * gridHeight;
+
+    gridDiffs_.resize(gridCount);
+    gridCapacities_.assign(2 * gridCount, 0);
+
+    oldColors_.resize(gridWidth);
+    newColors_.resize(gridWidth);
+
+    for(int ly = 0; ly < gridHeight; ++ly)
     {
-        assert(seamVertexType == Vertex::Type::VertSeam);
+        const int y = gridBeg_.y + ly;
+
+        for(int lx = 0; lx < gridWidth; ++lx)
+        {
+            const int x = gridBeg_.x + lx;
+
+            const Region region = getRegion(
+                y - windowBeg_.y, x - windowBeg_.x);
+
+            if(region != Region::Overlap)
+            {
+                oldColors_[lx] = newColors_[lx] = 0;
+                continue;
+            }
+
+            const Int2 localPos = Int2(x, y) - patchBeg_;
+            oldColors_[lx] = packRGB(
+                patches.getRGB(texels.getPatchIndex(y, x), x, y));
+            newColors_[lx] = packRGB((*patch_)(localPos.y, localPos.x));
+        }
 
-        aVertex->edges[Vertex::EDGE_POS_Y] = a2Seam;
-        seamVertex->edges[Vertex::EDGE_NEG_Y] = a2Seam;
+        computeColorDiffs(
+            oldColors_.data(), newColors_.data(),
+            gridDiffs_.data() + size_t(ly) * gridWidth, gridWidth);
+    }
 
-        bVertex->edges[Vertex::EDGE_NEG_Y] = b2Seam;
-        seamVertex->edges[Vertex::EDGE_POS_Y] = b2Seam;
+    // +x edges of all columns but the last one, and +y edges of all rows but
+    // the last one. costs of missing edges are never read
 
-        seamVertex->edges[Vertex::EDGE_VERT_SEAM_TO_SRC] = seamSrcEdge;
+    for(int ly = 0; ly < gridHeight; ++ly)
+    {
+        const size_t rowBeg = size_t(ly) * gridWidth;
+        addShifted(
+            gridDiffs_.data() + rowBeg, 1,
+            gridCapacities_.data() + rowBeg, gridWidth - 1);
     }
 
-    return { seamVertex, seamSrc };
+    if(gridHeight > 1)
+    {
+        addShifted(
+            gridDiffs_.data(), gridWidth,
+            gridCapacities_.data() + gridCount,
+            (gridHeight - 1) * gridWidth);
+    }
 }
 
-void GraphBuilder::addEdge(
-    const Int2 &aPos, Texel &aTexel, Vertex *aVertex,
-    const Int2 &bPos, Texel &bTexel, Vertex *bVertex,
-    const PatchHistory &patches,
-    bool isVertical)
+void GraphBuilder::initGrid()
 {
-    Edge *e = edgeArena_.create();
+    // find bounding box of overlap region
 
-    const int cost = computeSeamCost(
-        aTexel.patchIndex, bTexel.patchIndex, patches.getCurrentIndex(),
-        aPos, bPos, patches);
+    Int2 overlapBeg = windowEnd_;
+    Int2 overlapEnd = windowBeg_;
 
-    e->a = aVertex;
-    e->b = bVertex;
-    e->capacity = cost;
+    for(int y = windowBeg_.y; y < windowEnd_.y; ++y)
+    {
+        for(int x = windowBeg_.x; x < windowEnd_.x; ++x)
+        {
+            if(getRegion(y - windowBeg_.y, x - windowBeg_.x) == Region::Overlap)
+            {
+                overlapBeg.x = std::min(overlapBeg.x, x);
+                overlapBeg.y = std::min(overlapBeg.y, y);
+                overlapEnd.x = std::max(overlapEnd.x, x + 1);
+                overlapEnd.y = std::max(overlapEnd.y, y + 1);
+            }
+        }
+    }
 
-    if(isVertical)
+    if(overlapBeg.x >= overlapEnd.x)
     {
-        aVertex->edges[Vertex::EDGE_POS_Y] = e;
-        bVertex->edges[Vertex::EDGE_NEG_Y] = e;
+        gridBeg_  = { 0, 0 };
+        gridSize_ = { 0, 0 };
     }
     else
     {
-        aVertex->edges[Vertex::EDGE_POS_X] = e;
-        bVertex->edges[Vertex::EDGE_NEG_X] = e;
+        gridBeg_  = overlapBeg;
+        gridSize_ = overlapEnd - overlapBeg;
+    }
+
+    graph_->initGrid(gridBeg_, gridSize_);
+}
+
+void GraphBuilder::addSeam(
+    const Int2 &aPos, const Texel &aTexel,
+    const Int2 &bPos, const Texel &bTexel,
+    int seamCost, Graph::VertexType seamVertexType,
+    const PatchHistory &patches)
+{
+    const Graph::Index aVertex = graph_->getTexelVertex(aPos);
+    const Graph::Index bVertex = graph_->getTexelVertex(bPos);
+
+    // keeping the old seam means cutting its t-link from src
+
+    const Graph::Index seamVertex = graph_->addVertex(seamVertexType, aPos);
+    graph_->setTerminalCapacity(seamVertex, seamCost);
+
+    const int a2SeamCost = computeSeamCost(
+        aTexel.patchIndex, patchIndex_,
+        aPos, bPos, patches);
+    const int b2SeamCost = computeSeamCost(
+        bTexel.patchIndex, patchIndex_,
+        aPos, bPos, patches);
+
+    graph_->addEdge(aVertex, seamVertex, a2SeamCost);
+    graph_->addEdge(bVertex, seamVertex, b2SeamCost);
+}
+
+void GraphBuilder::setSrc(const Int2 &pos)
+{
+    const Graph::Index v = graph_->getTexelVertex(pos);
+    if(!graph_->isSink(v))
+        graph_->setTerminalCapacity(v, Graph::INF_CAPACITY);
+}
+
+void GraphBuilder::setSink(const Int2 &pos)
+{
+    const Graph::Index v = graph_->getTexelVertex(pos);
+    graph_->setTerminalCapacity(v, -Graph::INF_CAPACITY);
+}
+
+void GraphBuilder::addEdge(const Int2 &aPos, const Int2 &bPos)
+{
+    const Graph::Index aVertex = graph_->getTexelVertex(aPos);
+    if(aPos.y == bPos.y)
+        graph_->addGridEdgeX(aVertex, gridCapacities_[aVertex]);
+    else
+    {
+        const size_t gridCount = size_t(gridSize_.x) * gridSize_.y;
+        graph_->addGridEdgeY(aVertex, gridCapacities_[gridCount + aVertex]);
     }
 }
 
 void GraphBuilder::handleNeighbors(
-    std::set<Vertex *> &allVertices,
-    const Int2 &aPos, Texel &aTexel, Region aRegion,
-    const Int2 &bPos, Texel &bTexel, Region bRegion,
+    const Int2 &aPos, const Texel &aTexel, Region aRegion,
+    const Int2 &bPos, const Texel &bTexel, Region bRegion,
     const PatchHistory &patches)
 {
     assert(bPos == aPos + Int2(0, 1) || bPos == aPos + Int2(1, 0));
 
     if(aRegion == Region::Old && bRegion == Region::Overlap)
-    {
-        auto bVertex = &bTexel.texelVertex;
-        bVertex->isSink = true;
-        allVertices.insert(bVertex);
-    }
+        setSink(bPos);
     else if(aRegion == Region::Overlap && bRegion == Region::Old)
-    {
-        auto aVertex = &aTexel.texelVertex;
-        aVertex->isSink = true;
-        allVertices.insert(aVertex);
-    }
+        setSink(aPos);
     else if(aRegion == Region::New && bRegion == Region::Overlap)
-    {
-        auto bVertex = &bTexel.texelVertex;
-        bVertex->isSrc = true;
-        allVertices.insert(bVertex);
-    }
+        setSrc(bPos);
     else if(aRegion == Region::Overlap && bRegion == Region::New)
-    {
-        auto aVertex = &aTexel.texelVertex;
-        aVertex->isSrc = true;
-        allVertices.insert(aVertex);
-    }
+        setSrc(aPos);
     else if(aRegion == Region::Overlap && bRegion == Region::Overlap)
     {
-        auto aVertex = &aTexel.texelVertex;
-        auto bVertex = &bTexel.texelVertex;
-        allVertices.insert(aVertex);
-        allVertices.insert(bVertex);
+        const bool isHori = aPos.y == bPos.y;
+        const int seamCost = isHori ? aTexel.xPosSeamCost
+                                    : aTexel.yPosSeamCost;
 
-        if(aPos.y == bPos.y)
+        if(seamCost)
         {
-            if(aTexel.xPosSeamCost)
-            {
-                auto [seam, seamSrc] = addSeam(
-                    aPos, aTexel, aVertex,
-                    bPos, bTexel, bVertex,
-                    aTexel.xPosSeamCost, Vertex::Type::HoriSeam,
-                    patches);
-
-                allVertices.insert(seam);
-                allVertices.insert(seamSrc);
-            }
-            else
-            {
-                addEdge(
-                    aPos, aTexel, aVertex,
-                    bPos, bTexel, bVertex,
-                    patches, false);
-            }
+            addSeam(
+                aPos, aTexel, bPos, bTexel, seamCost,
+                isHori ? Graph::VertexType::HoriSeam
+                       : Graph::VertexType::VertSeam,
+                patches);
         }
         else
-        {
-            if(aTexel.yPosSeamCost)
-            {
-                auto [seam, seamSrc] = addSeam(
-                    aPos, aTexel, aVertex,
-                    bPos, bTexel, bVertex,
-                    aTexel.yPosSeamCost, Vertex::Type::VertSeam,
-                    patches);
-
-                allVertices.insert(seam);
-                allVertices.insert(seamSrc);
-            }
-            else
-            {
-                addEdge(
-                    aPos, aTexel, aVertex,
-                    bPos, bTexel, bVertex,
-                    patches, true);
-            }
-        }
+            addEdge(aPos, bPos);
     }
 }
 
@@ -1,39 +1,36 @@
 #pragma once
 
-#include <agz/utility/alloc.h>
-
 #include "graph.h"
 #include "patchHistory.h"
+#include "texelPlanes.h"
 
 GCTS_BEGIN
 
-struct Texel
-{
-    int patchIndex   = -1; // covered by which patch
-    int xPosSeamCost = 0;  // seam with +x neighbor
-    int yPosSeamCost = 0;  // seam with +y neighbor
-
-    bool keepXPosSeam = false;
-    bool keepYPosSeam = false;
-
-    Vertex texelVertex;
-};
-
 class GraphBuilder
 {
 public:
 
-    Graph build(
-        Image2D<Texel>         &texels,
+    // texels are only read, so builds of disjoint patches may run
+    // concurrently. storage of graph & the builder is reused
+    void build(
+        const TexelPlanes      &texels,
         const ImageView2D<RGB> &patch,
+        int                     patchIndex,
         const Int2             &patchBeg,
         const Int2             &patchOverlapSize,
-        const PatchHistory     &patchHistory);
+        const PatchHistory     &patchHistory,
+        Graph                  &graph);
 
-private:
+    // texels covered by the new patch regardless of the cut. they are to be
+    // assigned to the new patch by the caller, along with src side texels
+    const std::vector<Int2> &getNewTexels() const noexcept;
 
-    using EdgeArena   = agz::alloc::fixed_obj_arena_t<Edge>;
-    using VertexArena = agz::alloc::fixed_obj_arena_t<Vertex>;
+    // cost of the seam between patches A & B over neighboring texels s & t
+    static int computeSeamCost(
+        const RGB &As, const RGB &At,
+        const RGB &Bs, const RGB &Bt) noexcept;
+
+private:
 
     enum class Region
     {
@@ -43,47 +40,84 @@ private:
         Overlap
     };
 
-    Image2D<Region> buildRegionDistribution(
-        Image2D<Texel>         &texels,
+    // fill regions_ for texels in the window
+    void buildRegionDistribution(
+        const TexelPlanes      &texels,
         const ImageView2D<RGB> &patch,
         const Int2             &patchBeg,
-        const Int2             &patchOverlapSize) const;
+        const Int2             &patchOverlapSize);
 
-    int computeSeamCost(
-        const RGB &As, const RGB &At,
-        const RGB &Bs, const RGB &Bt) const;
+    // region of texel at windowBeg_ + (lx, ly)
+    Region &getRegion(int ly, int lx) noexcept;
+
+    // color of patch at position. the new patch is read from patch_
+    const RGB &getRGB(
+        int patchIndex, const Int2 &position,
+        const PatchHistory &patches) const noexcept;
 
     int computeSeamCost(
         int AIndex, int BIndex,
         const Int2 &s, const Int2 &t,
         const PatchHistory &patches) const;
 
-    int computeSeamCost(
-        int AIndex, int BIndex, int CIndex,
-        const Int2 &s, const Int2 &t,
-        const PatchHistory &patches) const;
+    // r | g << 8 | b << 16
+    static uint32_t packRGB(const RGB &color) noexcept;
+
+    // diffs[i] = sum of per-channel |a[i] - b[i]| of packed colors
+    static void computeColorDiffs(
+        const uint32_t *a, const uint32_t *b, int *diffs, int count) noexcept;
+
+    // sums[i] = diffs[i] + diffs[i + shift]
+    static void addShifted(
+        const int *diffs, int shift, int *sums, int count) noexcept;
 
-    // returns: (seam vertex, seam src vertex)
-    std::pair<Vertex *, Vertex *> addSeam(
-        const Int2 &aPos, Texel &aTexel, Vertex *aVertex,
-        const Int2 &bPos, Texel &bTexel, Vertex *bVertex,
-        int seamCost, Vertex::Type seamVertexType,
+    void initGrid();
+
+    // capacities of grid edges between overlap texels, laid out as in Graph
+    void computeGridEdgeCapacities(
+        const TexelPlanes &texels, const PatchHistory &patches);
+
+    void addSeam(
+        const Int2 &aPos, const Texel &aTexel,
+        const Int2 &bPos, const Texel &bTexel,
+        int seamCost, Graph::VertexType seamVertexType,
         const PatchHistory &patches);
 
-    void addEdge(
-        const Int2 &aPos, Texel &aTexel, Vertex *aVertex,
-        const Int2 &bPos, Texel &bTexel, Vertex *bVertex,
-        const PatchHistory &patches,
-        bool isVertical);
+    // a texel adjacent to both old & new texels is left to the old patch
+    void setSrc (const Int2 &pos);
+    void setSink(const Int2 &pos);
+
+    void addEdge(const Int2 &aPos, const Int2 &bPos);
 
     void handleNeighbors(
-        std::set<Vertex*> &allVertices,
-        const Int2 &aPos, Texel &aTexel, Region aRegion,
-        const Int2 &bPos, Texel &bTexel, Region bRegion,
+        const Int2 &aPos, const Texel &aTexel, Region aRegion,
+        const Int2 &bPos, const Texel &bTexel, Region bRegion,
         const PatchHistory &patches);
 
-    EdgeArena   edgeArena_;
-    VertexArena vertexArena_;
+    // the new patch & its index in patch history
+    const ImageView2D<RGB> *patch_ = nullptr;
+    int patchIndex_ = -1;
+    Int2 patchBeg_;
+
+    std::vector<Int2> newTexels_;
+
+    // part of the image processed in current build
+    Int2 windowBeg_;
+    Int2 windowEnd_;
+
+    std::vector<Region> regions_;
+
+    // overlap bounding box, covered by the texel grid of the graph
+    Int2 gridBeg_;
+    Int2 gridSize_;
+
+    // per-texel color differences & edge capacities of the grid
+    std::vector<int>      gridDiffs_;
+    std::vector<int>      gridCapacities_;
+    std::vector<uint32_t> oldColors_;
+    std::vector<uint32_t> newColors_;
+
+    Graph *graph_ = nullptr;
 };
 
 GCTS_END
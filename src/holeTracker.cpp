@@ -0,0 +1,45 @@
+#include <algorithm>
+
+#include "holeTracker.h"
+
+GCTS_BEGIN
+
+HoleTracker::HoleTracker(const Int2 &size)
+    : width_(size.x), isFilled_(size_t(size.x) * size.y)
+{
+
+}
+
+void HoleTracker::markFilled(const Int2 &position) noexcept
+{
+    const size_t i = size_t(position.y) * width_ + position.x;
+    if(!isFilled_[i])
+    {
+        isFilled_.set(i);
+        ++filledCount_;
+    }
+}
+
+Int2 HoleTracker::findFirstHole() noexcept
+{
+    cursor_ = isFilled_.findNextUnset(cursor_);
+    if(cursor_ >= isFilled_.size())
+        return { -1, -1 };
+    return { int(cursor_ % width_), int(cursor_ / width_) };
+}
+
+int HoleTracker::findFirstHoleInRow(int y) const noexcept
+{
+    const size_t rowBeg = size_t(y) * width_;
+    const size_t hole = isFilled_.findNextUnset(std::max(rowBeg, cursor_));
+    return int(std::min(hole - rowBeg, size_t(width_)));
+}
+
+float HoleTracker::getFilledRatio() const noexcept
+{
+    if(!isFilled_.size())
+        return 1;
+    return float(filledCount_) / isFilled_.size();
+}
+
+GCTS_END
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "bitmap.h"
+
+GCTS_BEGIN
+
+/*
+ * tracks texels not covered by any patch.
+ *
+ * texels are never uncovered once covered, so the first hole in row-major
+ * order only moves forward and can be found by advancing a cursor over an
+ * occupancy bitmap. the cursor skips 64 covered texels at a time and visits
+ * each of them at most once over the whole synthesis.
+ */
+class HoleTracker
+{
+public:
+
+    explicit HoleTracker(const Int2 &size);
+
+    void markFilled(const Int2 &position) noexcept;
+
+    // first hole in row-major order. (-1, -1) if there is no hole
+    Int2 findFirstHole() noexcept;
+
+    // x of the first hole in row y. width if the row is filled
+    int findFirstHoleInRow(int y) const noexcept;
+
+    float getFilledRatio() const noexcept;
+
+private:
+
+    int width_ = 0;
+
+    Bitmap isFilled_;
+    size_t filledCount_ = 0;
+
+    size_t cursor_ = 0;
+};
+
+GCTS_END
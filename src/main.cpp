@@ -22,21 +22,46 @@ struct Options
 
     gcts::Synthesizer::PatchPlacementStrategy patchPlacement =
         gcts::Synthesizer::Random;
+
+    gcts::Synthesizer::MaxFlowSolverType maxFlowSolver =
+        gcts::Synthesizer::MaxFlowSolverType::Auto;
+
+    gcts::Synthesizer::MaxFlowSolverLayers maxFlowSolverLayers;
+
+    int timeBudgetMs = 0;
+
+    int patchBatchSize = 1;
+    int candidateCount = 1;
+
+    bool optimisticRefinement = false;
+
+    int   convergenceWindow    = 0;
+    float convergenceThreshold = 0;
 };
 
 std::optional<Options> parseOptions(int argc, char *argv[])
 {
     cxxopts::Options options("GCTS");
     options.add_options("")
-        ("i,input",      "input filename (jpg, png, bmp)",    cxxopts::value<std::string>())
-        ("o,output",     "output filename (jpg, png, bmp)",   cxxopts::value<std::string>())
-        ("w,width",      "output width",                      cxxopts::value<int>())
-        ("h,height",     "output height",                     cxxopts::value<int>())
-        ("m,pwidth",     "patch width",                       cxxopts::value<int>()->default_value("-1"))
-        ("n,pheight",    "patch height",                      cxxopts::value<int>()->default_value("-1"))
-        ("c,patchCount", "additional patch count",            cxxopts::value<int>()->default_value("-1"))
-        ("s,strategy",   "patch placement strategy (random)", cxxopts::value<std::string>()->default_value("random"))
-        ("help",         "help information");
+        ("i,input",        "input filename (jpg, png, bmp)",                 cxxopts::value<std::string>())
+        ("o,output",       "output filename (jpg, png, bmp)",                cxxopts::value<std::string>())
+        ("w,width",        "output width",                                   cxxopts::value<int>())
+        ("h,height",       "output height",                                  cxxopts::value<int>())
+        ("m,pwidth",       "patch width",                                    cxxopts::value<int>()->default_value("-1"))
+        ("n,pheight",      "patch height",                                   cxxopts::value<int>()->default_value("-1"))
+        ("c,patchCount",   "additional patch count",                         cxxopts::value<int>()->default_value("-1"))
+        ("s,strategy",     "patch placement strategy (random, entire, sub)", cxxopts::value<std::string>()->default_value("random"))
+        ("solver",         "max flow solver (auto, bk, pr, dinic)",          cxxopts::value<std::string>()->default_value("auto"))
+        ("reduce",         "reduce graphs before max flow (exact)",          cxxopts::value<bool>()->default_value("true"))
+        ("coarseToFine",   "cut large graphs coarse-to-fine (approximate)",  cxxopts::value<bool>()->default_value("false"))
+        ("planar",         "cut seam-free graphs in planar dual (exact)",    cxxopts::value<bool>()->default_value("false"))
+        ("timeBudgetMs",   "time budget in milliseconds (0: unlimited)",     cxxopts::value<int>()->default_value("0"))
+        ("batch",          "patches placed concurrently (1: sequential)",    cxxopts::value<int>()->default_value("1"))
+        ("candidates",     "candidate placements per patch",                 cxxopts::value<int>()->default_value("1"))
+        ("optimistic",     "paste additional patches optimistically",        cxxopts::value<bool>()->default_value("false"))
+        ("convWindow",     "early stop window, in patches (0: off)",         cxxopts::value<int>()->default_value("0"))
+        ("convThreshold",  "min relative seam cost drop between windows",    cxxopts::value<float>()->default_value("0.01"))
+        ("help",           "help information");
     const auto args = options.parse(argc, argv);
 
     if(args.count("help"))
@@ -56,15 +81,45 @@ std::optional<Options> parseOptions(int argc, char *argv[])
         result.patchWidth           = args["pwidth"].as<int>();
         result.patchHeight          = args["pheight"].as<int>();
         result.additionalPatchCount = args["patchCount"].as<int>();
+        result.timeBudgetMs         = args["timeBudgetMs"].as<int>();
+        result.patchBatchSize       = args["batch"].as<int>();
+        result.candidateCount       = args["candidates"].as<int>();
+        result.optimisticRefinement = args["optimistic"].as<bool>();
+        result.convergenceWindow    = args["convWindow"].as<int>();
+        result.convergenceThreshold = args["convThreshold"].as<float>();
+
+        auto &layers = result.maxFlowSolverLayers;
+        layers.reduction    = args["reduce"].as<bool>();
+        layers.coarseToFine = args["coarseToFine"].as<bool>();
+        layers.planar       = args["planar"].as<bool>();
 
         const std::string strategy = args["strategy"].as<std::string>();
         if(strategy == "random")
             result.patchPlacement = gcts::Synthesizer::Random;
+        else if(strategy == "entire")
+            result.patchPlacement = gcts::Synthesizer::EntirePatchMatching;
+        else if(strategy == "sub")
+            result.patchPlacement = gcts::Synthesizer::SubPatchMatching;
         else
         {
             throw std::runtime_error(
                 "unknown patch placement strategy: " + strategy);
         }
+
+        const std::string solver = args["solver"].as<std::string>();
+        if(solver == "auto")
+            result.maxFlowSolver = gcts::Synthesizer::MaxFlowSolverType::Auto;
+        else if(solver == "bk")
+            result.maxFlowSolver = gcts::Synthesizer::MaxFlowSolverType::BK;
+        else if(solver == "pr")
+        {
+            result.maxFlowSolver =
+                gcts::Synthesizer::MaxFlowSolverType::PushRelabel;
+        }
+        else if(solver == "dinic")
+            result.maxFlowSolver = gcts::Synthesizer::MaxFlowSolverType::Dinic;
+        else
+            throw std::runtime_error("unknown max flow solver: " + solver);
     }
     catch(...)
     {
@@ -107,7 +162,15 @@ void run(int argc, char *argv[])
     syn.setParams(
         { options->patchWidth, options->patchHeight },
         options->additionalPatchCount,
-        options->patchPlacement);
+        options->patchPlacement,
+        options->maxFlowSolver,
+        options->timeBudgetMs);
+    syn.setMaxFlowSolverLayers(options->maxFlowSolverLayers);
+    syn.setPatchBatchSize(options->patchBatchSize);
+    syn.setCandidateCount(options->candidateCount);
+    syn.setOptimisticRefinement(options->optimisticRefinement);
+    syn.setConvergenceParams(
+        options->convergenceWindow, options->convergenceThreshold);
 
     const auto out = syn.generate(
         src, { options->outputWidth, options->outputHeight });
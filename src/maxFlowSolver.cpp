@@ -0,0 +1,70 @@
+#include "autoSolver.h"
+#include "bkSolver.h"
+#include "coarseToFineSolver.h"
+#include "dinicSolver.h"
+#include "planarSolver.h"
+#include "pushRelabelSolver.h"
+#include "reducingSolver.h"
+
+GCTS_BEGIN
+
+void MaxFlowSolver::findCutEdges(const Graph &graph, MinCutResult &ret)
+{
+    ret.cut.clear();
+
+    const Graph::Index edgeCount = graph.getEdgeCount();
+    for(Graph::Index e = 0; e < edgeCount; ++e)
+    {
+        if(graph.hasEdge(e) &&
+           ret.reachableVertices[graph.getEdgeA(e)] !=
+           ret.reachableVertices[graph.getEdgeB(e)])
+            ret.cut.push_back(e);
+    }
+
+    ret.cutTerminalLinks.clear();
+
+    for(Graph::Index v = 0; v < graph.getVertexCount(); ++v)
+    {
+        const int capacity = graph.getTerminalCapacity(v);
+        if((capacity > 0 && !ret.reachableVertices[v]) ||
+           (capacity < 0 &&  ret.reachableVertices[v]))
+            ret.cutTerminalLinks.push_back(v);
+    }
+}
+
+std::unique_ptr<MaxFlowSolver> createMaxFlowSolver(
+    Synthesizer::MaxFlowSolverType type, ThreadPool &threadPool)
+{
+    std::unique_ptr<MaxFlowSolver> solver;
+    switch(type)
+    {
+    case Synthesizer::MaxFlowSolverType::Auto:
+        solver = std::make_unique<AutoSolver>(threadPool);
+        break;
+    case Synthesizer::MaxFlowSolverType::BK:
+        solver = std::make_unique<BKSolver>();
+        break;
+    case Synthesizer::MaxFlowSolverType::PushRelabel:
+        solver = std::make_unique<PushRelabelSolver>(threadPool);
+        break;
+    case Synthesizer::MaxFlowSolverType::Dinic:
+        solver = std::make_unique<DinicSolver>();
+        break;
+    }
+    return solver;
+}
+
+std::unique_ptr<MaxFlowSolver> wrapMaxFlowSolver(
+    std::unique_ptr<MaxFlowSolver>          solver,
+    const Synthesizer::MaxFlowSolverLayers &layers)
+{
+    if(layers.reduction)
+        solver = std::make_unique<ReducingSolver>(std::move(solver));
+    if(layers.coarseToFine)
+        solver = std::make_unique<CoarseToFineSolver>(std::move(solver));
+    if(layers.planar)
+        solver = std::make_unique<PlanarSolver>(std::move(solver));
+    return solver;
+}
+
+GCTS_END
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "graph.h"
+
+GCTS_BEGIN
+
+class ThreadPool;
+
+struct MinCutResult
+{
+    Bitmap                    reachableVertices; // indexed by vertex
+    std::vector<Graph::Index> cut;               // edges
+    std::vector<Graph::Index> cutTerminalLinks;  // vertices with cut t-links
+};
+
+/*
+ * finds the min cut separating the src terminal from the sink terminal.
+ * src/sink vertices are connected to them by infinite t-links, and other
+ * vertices may have finite ones. the src side of the cut is the set of
+ * vertices reachable from src in the residual graph of a max flow.
+ *
+ * when a deadline is set and passes during a call, the solver stops and
+ * returns the best cut found so far. it still separates src vertices from
+ * sink vertices, but is not necessarily minimal.
+ *
+ * the returned result is owned by the solver and stays valid until the next
+ * call. its storage is reused by later calls
+ */
+class MaxFlowSolver
+{
+public:
+
+    using Clock = std::chrono::steady_clock;
+
+    virtual ~MaxFlowSolver() = default;
+
+    virtual void setDeadline(Clock::time_point deadline) noexcept
+    {
+        deadline_ = deadline;
+    }
+
+    virtual const MinCutResult &findMinCut(const Graph &graph) = 0;
+
+protected:
+
+    // fill ret.cut with edges between reachable & unreachable vertices, and
+    // ret.cutTerminalLinks with vertices whose finite t-links are cut
+    static void findCutEdges(const Graph &graph, MinCutResult &ret);
+
+    // returned by implementations
+    MinCutResult result_;
+
+    Clock::time_point getDeadline() const noexcept
+    {
+        return deadline_;
+    }
+
+    bool isPastDeadline() const noexcept
+    {
+        return Clock::now() >= deadline_;
+    }
+
+private:
+
+    Clock::time_point deadline_ = Clock::time_point::max();
+};
+
+std::unique_ptr<MaxFlowSolver> createMaxFlowSolver(
+    Synthesizer::MaxFlowSolverType type, ThreadPool &threadPool);
+
+// wrap solver in the enabled layers. from the innermost one: ReducingSolver,
+// CoarseToFineSolver & PlanarSolver
+std::unique_ptr<MaxFlowSolver> wrapMaxFlowSolver(
+    std::unique_ptr<MaxFlowSolver>          solver,
+    const Synthesizer::MaxFlowSolverLayers &layers);
+
+GCTS_END
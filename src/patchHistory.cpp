@@ -9,6 +9,11 @@ void PatchHistory::addNewPatch(
     patches_.push_back({ patch, patchBeg });
 }
 
+void PatchHistory::reserve(size_t patchCount)
+{
+    patches_.reserve(patchCount);
+}
+
 int PatchHistory::getCurrentIndex() const noexcept
 {
     return static_cast<int>(patches_.size()) - 1;
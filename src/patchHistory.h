@@ -10,6 +10,9 @@ public:
 
     void addNewPatch(const ImageView2D<RGB> &patch, const Int2 &patchBeg);
 
+    // make room for patchCount patches in total
+    void reserve(size_t patchCount);
+
     int getCurrentIndex() const noexcept;
 
     const ImageView2D<RGB> &getCurrentPatch() const noexcept;
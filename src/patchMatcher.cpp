@@ -0,0 +1,286 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "patchMatcher.h"
+
+GCTS_BEGIN
+
+PatchMatcher::PatchMatcher(const Image2D<RGB> &src, const Int2 &patchSize)
+    : src_(src), patchSize_(patchSize),
+      candidateCount_(
+          src.width()  - patchSize.x + 1,
+          src.height() - patchSize.y + 1),
+      fft_(
+          FFT2D::ceilPowerOf2(src.width()),
+          FFT2D::ceilPowerOf2(src.height()))
+{
+    const int fftWidth = fft_.getWidth();
+    const size_t fftSize = size_t(fftWidth) * fft_.getHeight();
+
+    // variance of src pixel values
+
+    double sum = 0, sqrSum = 0;
+    for(int y = 0; y < src.height(); ++y)
+    {
+        for(int x = 0; x < src.width(); ++x)
+        {
+            for(int c = 0; c < 3; ++c)
+            {
+                const double v = getChannel(src(y, x), c);
+                sum    += v;
+                sqrSum += v * v;
+            }
+        }
+    }
+
+    const double valueCount = 3.0 * src.width() * src.height();
+    const double mean = sum / valueCount;
+    variance_ = sqrSum / valueCount - mean * mean;
+
+    // src spectra
+
+    for(int c = 0; c < 3; ++c)
+    {
+        srcSpectra_[c].assign(fftSize, 0);
+        for(int y = 0; y < src.height(); ++y)
+        {
+            for(int x = 0; x < src.width(); ++x)
+                srcSpectra_[c][y * fftWidth + x] = getChannel(src(y, x), c);
+        }
+        fft_.forward(srcSpectra_[c].data());
+    }
+
+    // squared colors, as a spectrum and as a summed-area table
+
+    const int tableWidth = src.width() + 1;
+
+    srcSqrSpectrum_.assign(fftSize, 0);
+    srcSqrTable_.assign(size_t(tableWidth) * (src.height() + 1), 0);
+
+    for(int y = 0; y < src.height(); ++y)
+    {
+        int64_t rowSum = 0;
+        for(int x = 0; x < src.width(); ++x)
+        {
+            int sqrColor = 0;
+            for(int c = 0; c < 3; ++c)
+            {
+                const int v = getChannel(src(y, x), c);
+                sqrColor += v * v;
+            }
+            srcSqrSpectrum_[y * fftWidth + x] = sqrColor;
+
+            rowSum += sqrColor;
+            srcSqrTable_[(y + 1) * tableWidth + x + 1] =
+                srcSqrTable_[y * tableWidth + x + 1] + rowSum;
+        }
+    }
+    fft_.forward(srcSqrSpectrum_.data());
+
+    targetColors_.resize(size_t(patchSize.x) * patchSize.y);
+    isTargetCovered_.assign(targetColors_.size(), false);
+}
+
+int PatchMatcher::getChannel(const RGB &color, int c) noexcept
+{
+    return c == 0 ? color.r : (c == 1 ? color.g : color.b);
+}
+
+void PatchMatcher::clearTarget()
+{
+    isTargetCovered_.assign(targetColors_.size(), false);
+}
+
+void PatchMatcher::setTargetTexel(const Int2 &position, const RGB &color)
+{
+    const size_t i = size_t(position.y) * patchSize_.x + position.x;
+    targetColors_[i] = color;
+    isTargetCovered_.set(i);
+}
+
+Int2 PatchMatcher::matchEntirePatch(std::default_random_engine &rng)
+{
+    const int fftWidth = fft_.getWidth();
+    const size_t fftSize = size_t(fftWidth) * fft_.getHeight();
+
+    int coveredCount = 0;
+    double targetSqrSum = 0;
+
+    for(size_t i = 0; i < targetColors_.size(); ++i)
+    {
+        if(!isTargetCovered_[i])
+            continue;
+
+        ++coveredCount;
+        for(int c = 0; c < 3; ++c)
+        {
+            const double v = getChannel(targetColors_[i], c);
+            targetSqrSum += v * v;
+        }
+    }
+
+    if(!coveredCount)
+    {
+        std::uniform_int_distribution disX(0, candidateCount_.x - 1);
+        std::uniform_int_distribution disY(0, candidateCount_.y - 1);
+        const int x = disX(rng);
+        const int y = disY(rng);
+        return { x, y };
+    }
+
+    // accumulate spectrum of the position-dependent part of SSD
+
+    accumulateColorCorrelations({ 0, 0 }, patchSize_);
+
+    buffer_.assign(fftSize, 0);
+    for(int y = 0; y < patchSize_.y; ++y)
+    {
+        for(int x = 0; x < patchSize_.x; ++x)
+        {
+            if(isTargetCovered_[size_t(y) * patchSize_.x + x])
+                buffer_[y * fftWidth + x] = 1;
+        }
+    }
+    fft_.forward(buffer_.data());
+
+    for(size_t k = 0; k < fftSize; ++k)
+        accum_[k] += std::conj(buffer_[k]) * srcSqrSpectrum_[k];
+
+    fft_.inverse(accum_.data());
+
+    // normalized costs of all src positions
+
+    costs_.resize(size_t(candidateCount_.x) * candidateCount_.y);
+    for(int y = 0; y < candidateCount_.y; ++y)
+    {
+        for(int x = 0; x < candidateCount_.x; ++x)
+        {
+            const double ssd = targetSqrSum + accum_[y * fftWidth + x].real();
+            costs_[y * candidateCount_.x + x] =
+                std::max(0.0, ssd) / coveredCount;
+        }
+    }
+
+    return pickPosition(costs_, rng);
+}
+
+Int2 PatchMatcher::matchSubPatch(
+    const Int2                 &subBeg,
+    const Int2                 &subSize,
+    std::default_random_engine &rng)
+{
+    const int fftWidth = fft_.getWidth();
+    const Int2 subEnd = subBeg + subSize;
+
+    double targetSqrSum = 0;
+    for(int y = subBeg.y; y < subEnd.y; ++y)
+    {
+        for(int x = subBeg.x; x < subEnd.x; ++x)
+        {
+            const size_t i = size_t(y) * patchSize_.x + x;
+            assert(isTargetCovered_[i]);
+
+            for(int c = 0; c < 3; ++c)
+            {
+                const double v = getChannel(targetColors_[i], c);
+                targetSqrSum += v * v;
+            }
+        }
+    }
+
+    accumulateColorCorrelations(subBeg, subEnd);
+    fft_.inverse(accum_.data());
+
+    // normalized costs of all src positions. the src part of SSD is read
+    // from the summed-area table
+
+    const double texelCount = double(subSize.x) * subSize.y;
+
+    costs_.resize(size_t(candidateCount_.x) * candidateCount_.y);
+    for(int y = 0; y < candidateCount_.y; ++y)
+    {
+        for(int x = 0; x < candidateCount_.x; ++x)
+        {
+            const Int2 srcSubBeg = Int2(x, y) + subBeg;
+            const double srcSqrSum = static_cast<double>(
+                getSrcSqrSum(srcSubBeg, srcSubBeg + subSize));
+
+            const double ssd = targetSqrSum + srcSqrSum
+                             + accum_[y * fftWidth + x].real();
+            costs_[y * candidateCount_.x + x] =
+                std::max(0.0, ssd) / texelCount;
+        }
+    }
+
+    return pickPosition(costs_, rng);
+}
+
+void PatchMatcher::accumulateColorCorrelations(
+    const Int2 &beg, const Int2 &end)
+{
+    const int fftWidth = fft_.getWidth();
+    const size_t fftSize = size_t(fftWidth) * fft_.getHeight();
+
+    accum_.assign(fftSize, 0);
+
+    for(int c = 0; c < 3; ++c)
+    {
+        buffer_.assign(fftSize, 0);
+        for(int y = beg.y; y < end.y; ++y)
+        {
+            for(int x = beg.x; x < end.x; ++x)
+            {
+                const size_t i = size_t(y) * patchSize_.x + x;
+                if(isTargetCovered_[i])
+                {
+                    buffer_[y * fftWidth + x] =
+                        double(getChannel(targetColors_[i], c));
+                }
+            }
+        }
+        fft_.forward(buffer_.data());
+
+        for(size_t k = 0; k < fftSize; ++k)
+            accum_[k] -= 2.0 * std::conj(buffer_[k]) * srcSpectra_[c][k];
+    }
+}
+
+int64_t PatchMatcher::getSrcSqrSum(
+    const Int2 &beg, const Int2 &end) const noexcept
+{
+    const int tableWidth = src_.width() + 1;
+    return srcSqrTable_[end.y * tableWidth + end.x]
+         - srcSqrTable_[beg.y * tableWidth + end.x]
+         - srcSqrTable_[end.y * tableWidth + beg.x]
+         + srcSqrTable_[beg.y * tableWidth + beg.x];
+}
+
+Int2 PatchMatcher::pickPosition(
+    const std::vector<double>  &costs,
+    std::default_random_engine &rng)
+{
+    const double minCost = *std::min_element(costs.begin(), costs.end());
+    const double temperature = std::max(K * variance_, 1e-6);
+
+    // cumulative weights, relative to the best position
+
+    auto &cdf = cdf_;
+    cdf.resize(costs.size());
+
+    double total = 0;
+    for(size_t i = 0; i < costs.size(); ++i)
+    {
+        total += std::exp(-(costs[i] - minCost) / temperature);
+        cdf[i] = total;
+    }
+
+    std::uniform_real_distribution<double> dis(0, total);
+    const size_t i = std::min<size_t>(
+        std::upper_bound(cdf.begin(), cdf.end(), dis(rng)) - cdf.begin(),
+        costs.size() - 1);
+
+    return { int(i % candidateCount_.x), int(i / candidateCount_.x) };
+}
+
+GCTS_END
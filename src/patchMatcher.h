@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+
+#include "bitmap.h"
+#include "fft.h"
+
+GCTS_BEGIN
+
+/*
+ * picks src patches whose content matches the output around the placement
+ *
+ * entire patch matching (Kwatra et al., 2003): for each src position t of
+ * the patch, the cost C(t) is the SSD between the patch and the covered part
+ * of the output under it, normalized by the overlap area. t is picked with
+ * probability proportional to exp(-C(t) / (k * sigma^2)), where sigma^2 is
+ * the variance of src pixel values.
+ *
+ * with the overlap mask m and the masked output color O, SSD(t) is
+ *
+ *   sum m O^2 - 2 sum_c corr(m O_c, I_c)(t) + corr(m, sum_c I_c^2)(t)
+ *
+ * where I is the src image. spectra of I_c and sum_c I_c^2 are computed
+ * once, so each placement costs 4 forward FFTs and 1 inverse FFT.
+ *
+ * sub-patch matching: only a fully covered rectangle S of the patch is
+ * compared. m is 1 over S, so corr(m, sum_c I_c^2) is a box sum read from a
+ * summed-area table of sum_c I_c^2, leaving 3 forward FFTs and 1 inverse FFT.
+ */
+class PatchMatcher
+{
+public:
+
+    PatchMatcher(const Image2D<RGB> &src, const Int2 &patchSize);
+
+    // mark all texels under the patch as uncovered
+    void clearTarget();
+
+    // output color of a covered texel. position is relative to the patch
+    void setTargetTexel(const Int2 &position, const RGB &color);
+
+    // returns the src position of the patch.
+    // uniformly distributed when no texel is covered
+    Int2 matchEntirePatch(std::default_random_engine &rng);
+
+    // returns the src position of the patch, only comparing texels in
+    // [subBeg, subBeg + subSize) of the patch. these texels must be covered
+    Int2 matchSubPatch(
+        const Int2                 &subBeg,
+        const Int2                 &subSize,
+        std::default_random_engine &rng);
+
+private:
+
+    using Complex = FFT2D::Complex;
+
+    // relative to the variance of src pixel values
+    static constexpr double K = 0.01;
+
+    static int getChannel(const RGB &color, int c) noexcept;
+
+    // accum_ = -2 sum_c corr(m O_c, I_c), with m limited to [beg, end)
+    void accumulateColorCorrelations(const Int2 &beg, const Int2 &end);
+
+    // sum of sum_c I_c^2 over [beg, end) of src
+    int64_t getSrcSqrSum(const Int2 &beg, const Int2 &end) const noexcept;
+
+    Int2 pickPosition(
+        const std::vector<double>  &costs,
+        std::default_random_engine &rng);
+
+    const Image2D<RGB> &src_;
+    Int2 patchSize_;
+
+    // count of valid src positions on each axis
+    Int2 candidateCount_;
+
+    double variance_ = 0;
+
+    FFT2D fft_;
+
+    // spectra of src color channels & sum of squared colors
+    std::vector<Complex> srcSpectra_[3];
+    std::vector<Complex> srcSqrSpectrum_;
+
+    // summed-area table of sum_c I_c^2, (width + 1) * (height + 1)
+    std::vector<int64_t> srcSqrTable_;
+
+    // target texels under the patch
+    std::vector<RGB> targetColors_;
+    Bitmap           isTargetCovered_;
+
+    std::vector<Complex> buffer_;
+    std::vector<Complex> accum_;
+    std::vector<double>  costs_;
+    std::vector<double>  cdf_;
+};
+
+GCTS_END
@@ -0,0 +1,415 @@
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+#include "planarSolver.h"
+
+GCTS_BEGIN
+
+PlanarSolver::PlanarSolver(std::unique_ptr<MaxFlowSolver> fallback) noexcept
+    : fallback_(std::move(fallback))
+{
+
+}
+
+void PlanarSolver::setDeadline(Clock::time_point deadline) noexcept
+{
+    fallback_->setDeadline(deadline);
+}
+
+const MinCutResult &PlanarSolver::findMinCut(const Graph &graph)
+{
+    if(solve(graph))
+        return result_;
+    return fallback_->findMinCut(graph);
+}
+
+bool PlanarSolver::solve(const Graph &graph)
+{
+    graph_     = &graph;
+    gridWidth_ = graph.getGridWidth();
+    gridCount_ = graph.getGridVertexCount();
+
+    bool isSolved = false;
+    if(isSeamFree())
+    {
+        traceFaces();
+        if(splitOuterFaces())
+        {
+            buildDual();
+            isSolved = computePotentials() && collectReachableVertices();
+        }
+    }
+
+    if(isSolved)
+        findCutEdges(graph, result_);
+
+    graph_ = nullptr;
+    return isSolved;
+}
+
+bool PlanarSolver::isSeamFree() const noexcept
+{
+    if(graph_->getVertexCount() != gridCount_ ||
+       graph_->getEdgeCount()   != 2 * gridCount_)
+        return false;
+
+    for(Index v = 0; v < gridCount_; ++v)
+    {
+        if(graph_->getTerminalCapacity(v) &&
+           !graph_->isSrc(v) && !graph_->isSink(v))
+            return false;
+    }
+
+    return true;
+}
+
+PlanarSolver::Direction PlanarSolver::getDirection(Index arc) const noexcept
+{
+    const bool isForward = !(arc & 1);
+    if(Graph::getArcEdge(arc) < gridCount_)
+        return isForward ? East : West;
+    return isForward ? South : North;
+}
+
+Graph::Index PlanarSolver::getArc(Index v, Direction direction) const noexcept
+{
+    Index e = Graph::NIL, arc = Graph::NIL;
+    switch(direction)
+    {
+    case East:
+        e   = v;
+        arc = 2 * e;
+        break;
+    case South:
+        e   = gridCount_ + v;
+        arc = 2 * e;
+        break;
+    case West:
+        if(v % gridWidth_)
+        {
+            e   = v - 1;
+            arc = 2 * e + 1;
+        }
+        break;
+    case North:
+        if(v >= gridWidth_)
+        {
+            e   = gridCount_ + v - gridWidth_;
+            arc = 2 * e + 1;
+        }
+        break;
+    }
+    return e != Graph::NIL && graph_->hasEdge(e) ? arc : Graph::NIL;
+}
+
+Graph::Index PlanarSolver::getNextDart(Index dart) const noexcept
+{
+    // the arc after the reversed dart in clockwise order, or the reversed
+    // dart itself at a degree-1 vertex
+
+    const Index v    = graph_->getArcHead(dart);
+    const Index back = Graph::getSisterArc(dart);
+    const int   dir  = getDirection(back);
+
+    for(int i = 1; i < 4; ++i)
+    {
+        const Index arc = getArc(v, Direction((dir + i) % 4));
+        if(arc != Graph::NIL)
+            return arc;
+    }
+
+    return back;
+}
+
+void PlanarSolver::traceFaces()
+{
+    const Index arcCount = 2 * graph_->getEdgeCount();
+
+    dartFaces_.assign(arcCount, Graph::NIL);
+    faceDarts_.clear();
+    faceAreas_.clear();
+
+    for(Index first = 0; first < arcCount; ++first)
+    {
+        if(dartFaces_[first] != Graph::NIL ||
+           !graph_->hasEdge(Graph::getArcEdge(first)))
+            continue;
+
+        const Index face = Index(faceDarts_.size());
+
+        // shoelace formula with y pointing down. only outer faces get
+        // positive areas, or zero for trees
+
+        std::int64_t area = 0;
+        Index dart = first;
+        do
+        {
+            dartFaces_[dart] = face;
+
+            const Index a = graph_->getArcHead(Graph::getSisterArc(dart));
+            const Index b = graph_->getArcHead(dart);
+
+            const std::int64_t ax = a % gridWidth_, ay = a / gridWidth_;
+            const std::int64_t bx = b % gridWidth_, by = b / gridWidth_;
+            area += ax * by - bx * ay;
+
+            dart = getNextDart(dart);
+
+        } while(dart != first);
+
+        faceDarts_.push_back(first);
+        faceAreas_.push_back(area);
+    }
+}
+
+bool PlanarSolver::splitOuterFaces()
+{
+    const Index faceCount = Index(faceDarts_.size());
+
+    dartNodes_.assign(dartFaces_.begin(), dartFaces_.end());
+    dualNodeCount_ = faceCount;
+
+    terminalNodePairs_.clear();
+    isOnOuterFace_.assign(gridCount_, false);
+
+    auto isTerminal = [&](Index v)
+    {
+        return graph_->isSrc(v) || graph_->isSink(v);
+    };
+
+    for(Index face = 0; face < faceCount; ++face)
+    {
+        if(faceAreas_[face] < 0)
+            continue;
+
+        walk_.clear();
+        terminalPositions_.clear();
+
+        Index dart = faceDarts_[face];
+        do
+        {
+            const Index tail = graph_->getArcHead(Graph::getSisterArc(dart));
+            if(isTerminal(tail))
+            {
+                terminalPositions_.push_back(Index(walk_.size()));
+                isOnOuterFace_.set(tail);
+            }
+
+            walk_.push_back(dart);
+            dart = getNextDart(dart);
+
+        } while(dart != faceDarts_[face]);
+
+        const size_t terminalCount = terminalPositions_.size();
+        auto isSrcAt = [&](size_t i)
+        {
+            const Index dart = walk_[terminalPositions_[i % terminalCount]];
+            return graph_->isSrc(
+                graph_->getArcHead(Graph::getSisterArc(dart)));
+        };
+
+        int runBoundaryCount = 0;
+        for(size_t i = 0; i < terminalCount; ++i)
+        {
+            if(isSrcAt(i) != isSrcAt(i + 1))
+                ++runBoundaryCount;
+        }
+
+        // the component has no src/sink vertex, or only one kind of them,
+        // and needs no cut
+
+        if(!runBoundaryCount)
+            continue;
+
+        if(runBoundaryCount != 2)
+            return false;
+
+        // a new node for each segment between adjacent src/sink vertices
+
+        Index srcNode = Graph::NIL, sinkNode = Graph::NIL;
+        for(size_t i = 0; i < terminalCount; ++i)
+        {
+            const Index node = dualNodeCount_++;
+
+            const size_t beg = terminalPositions_[i];
+            const size_t end = i + 1 < terminalCount ?
+                               terminalPositions_[i + 1] :
+                               terminalPositions_[0] + walk_.size();
+            for(size_t j = beg; j < end; ++j)
+                dartNodes_[walk_[j % walk_.size()]] = node;
+
+            if(isSrcAt(i) && !isSrcAt(i + 1))
+                srcNode = node;
+            else if(!isSrcAt(i) && isSrcAt(i + 1))
+                sinkNode = node;
+        }
+
+        terminalNodePairs_.push_back({ srcNode, sinkNode });
+    }
+
+    // src/sink vertices not on outer faces can't be joined to terminals
+    // without crossing edges
+
+    for(Index v = 0; v < gridCount_; ++v)
+    {
+        if(!isTerminal(v) || isOnOuterFace_[v])
+            continue;
+
+        for(int dir = East; dir <= North; ++dir)
+        {
+            if(getArc(v, Direction(dir)) != Graph::NIL)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+void PlanarSolver::buildDual()
+{
+    const Index edgeCount = graph_->getEdgeCount();
+
+    dualOffsets_.assign(dualNodeCount_ + 1, 0);
+    for(Index e = 0; e < edgeCount; ++e)
+    {
+        if(!graph_->hasEdge(e))
+            continue;
+
+        const Index a = dartNodes_[2 * e], b = dartNodes_[2 * e + 1];
+        if(a != b)
+        {
+            ++dualOffsets_[a + 1];
+            ++dualOffsets_[b + 1];
+        }
+    }
+
+    for(Index node = 0; node < dualNodeCount_; ++node)
+        dualOffsets_[node + 1] += dualOffsets_[node];
+
+    auto &fillPos = stack_;
+    fillPos.assign(dualOffsets_.begin(), dualOffsets_.end() - 1);
+
+    dualEdges_.resize(dualOffsets_.back());
+    for(Index e = 0; e < edgeCount; ++e)
+    {
+        if(!graph_->hasEdge(e))
+            continue;
+
+        const Index a = dartNodes_[2 * e], b = dartNodes_[2 * e + 1];
+        if(a != b)
+        {
+            dualEdges_[fillPos[a]++] = e;
+            dualEdges_[fillPos[b]++] = e;
+        }
+    }
+}
+
+bool PlanarSolver::computePotentials()
+{
+    dists_.assign(dualNodeCount_, INF_DIST);
+
+    auto getOtherNode = [&](Index node, Index e)
+    {
+        const Index a = dartNodes_[2 * e];
+        return a == node ? dartNodes_[2 * e + 1] : a;
+    };
+
+    // components share no dual node. all nodes of a component are settled
+
+    for(auto &[srcNode, sinkNode] : terminalNodePairs_)
+    {
+        heap_.clear();
+
+        dists_[srcNode] = 0;
+        heap_.push_back({ 0, srcNode });
+
+        while(!heap_.empty())
+        {
+            std::pop_heap(heap_.begin(), heap_.end(), std::greater<>());
+            const auto [dist, node] = heap_.back();
+            heap_.pop_back();
+
+            if(dist > dists_[node])
+                continue;
+
+            for(Index i = dualOffsets_[node]; i < dualOffsets_[node + 1]; ++i)
+            {
+                const Index e     = dualEdges_[i];
+                const Index other = getOtherNode(node, e);
+
+                const std::int64_t newDist =
+                    dist + graph_->getEdgeCapacity(e);
+                if(newDist < dists_[other])
+                {
+                    dists_[other] = newDist;
+
+                    heap_.push_back({ newDist, other });
+                    std::push_heap(
+                        heap_.begin(), heap_.end(), std::greater<>());
+                }
+            }
+        }
+
+        if(dists_[sinkNode] == INF_DIST)
+            return false;
+    }
+
+    return true;
+}
+
+int PlanarSolver::getFlow(Index arc) const noexcept
+{
+    // flow along an edge is the difference of potentials across it
+
+    const std::int64_t a = dists_[dartNodes_[Graph::getSisterArc(arc)]];
+    const std::int64_t b = dists_[dartNodes_[arc]];
+    if(a == INF_DIST || b == INF_DIST)
+        return 0;
+    return int(a - b);
+}
+
+bool PlanarSolver::collectReachableVertices()
+{
+    MinCutResult &ret = result_;
+    ret.reachableVertices.assign(gridCount_, false);
+
+    stack_.clear();
+    for(Index v = 0; v < gridCount_; ++v)
+    {
+        if(graph_->isSrc(v))
+        {
+            ret.reachableVertices.set(v);
+            stack_.push_back(v);
+        }
+    }
+
+    bool isSeparated = true;
+    while(isSeparated && !stack_.empty())
+    {
+        const Index v = stack_.back();
+        stack_.pop_back();
+
+        graph_->forEachArc(v, [&](Index arc, Index u)
+        {
+            if(ret.reachableVertices[u] ||
+               graph_->getEdgeCapacity(Graph::getArcEdge(arc)) <=
+               getFlow(arc))
+                return false;
+
+            if(graph_->isSink(u))
+            {
+                isSeparated = false;
+                return true;
+            }
+
+            ret.reachableVertices.set(u);
+            stack_.push_back(u);
+            return false;
+        });
+    }
+
+    return isSeparated;
+}
+
+GCTS_END
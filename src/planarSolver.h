@@ -0,0 +1,104 @@
+#pragma once
+
+#include <limits>
+
+#include "maxFlowSolver.h"
+
+GCTS_BEGIN
+
+// min cut of seam-free graphs as shortest paths in the planar dual. other
+// graphs are passed to the fallback solver
+class PlanarSolver : public MaxFlowSolver
+{
+public:
+
+    using Index = Graph::Index;
+
+    explicit PlanarSolver(std::unique_ptr<MaxFlowSolver> fallback) noexcept;
+
+    void setDeadline(Clock::time_point deadline) noexcept override;
+
+    const MinCutResult &findMinCut(const Graph &graph) override;
+
+private:
+
+    // clockwise
+    enum Direction
+    {
+        East,
+        South,
+        West,
+        North,
+    };
+
+    // returns false if the graph is not handled
+    bool solve(const Graph &graph);
+
+    bool isSeamFree() const noexcept;
+
+    Direction getDirection(Index arc) const noexcept;
+
+    // arc leaving texel v in the direction. NIL if there is none
+    Index getArc(Index v, Direction direction) const noexcept;
+
+    // next dart along the face of the dart
+    Index getNextDart(Index dart) const noexcept;
+
+    void traceFaces();
+
+    // assign dual nodes to darts. returns false if any component violates
+    // the requirement on its src/sink vertices
+    bool splitOuterFaces();
+
+    void buildDual();
+
+    // distances of dual nodes from src nodes. returns false if any sink node
+    // is not reached
+    bool computePotentials();
+
+    // flow along a primal arc, given by potentials on its sides
+    int getFlow(Index arc) const noexcept;
+
+    // returns false if any sink vertex is reachable
+    bool collectReachableVertices();
+
+    std::unique_ptr<MaxFlowSolver> fallback_;
+
+    const Graph *graph_ = nullptr;
+
+    Index gridWidth_ = 0;
+    Index gridCount_ = 0;
+
+    // primal faces
+
+    std::vector<Index>        dartFaces_;  // indexed by arc
+    std::vector<Index>        faceDarts_;  // first dart of each face
+    std::vector<std::int64_t> faceAreas_;  // doubled signed areas
+
+    // dual graph. outer faces are split into segments
+
+    Index dualNodeCount_ = 0;
+
+    std::vector<Index> dartNodes_;   // node on the side of each dart
+    std::vector<Index> dualOffsets_;
+    std::vector<Index> dualEdges_;   // primal edges crossed by dual edges
+
+    std::vector<std::pair<Index, Index>> terminalNodePairs_;
+
+    std::vector<Index> walk_;
+    std::vector<Index> terminalPositions_;
+    Bitmap             isOnOuterFace_;
+
+    // shortest paths
+
+    static constexpr std::int64_t INF_DIST =
+        std::numeric_limits<std::int64_t>::max();
+
+    std::vector<std::int64_t> dists_;
+
+    std::vector<std::pair<std::int64_t, Index>> heap_;
+
+    std::vector<Index> stack_;
+};
+
+GCTS_END
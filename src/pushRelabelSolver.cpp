@@ -0,0 +1,518 @@
+#include <algorithm>
+#include <type_traits>
+
+#include "pushRelabelSolver.h"
+
+GCTS_BEGIN
+
+PushRelabelSolver::PushRelabelSolver(ThreadPool &threadPool) noexcept
+    : threadPool_(threadPool)
+{
+
+}
+
+const MinCutResult &PushRelabelSolver::findMinCut(const Graph &graph)
+{
+    init(graph);
+
+    // phase 1: max preflow from src vertices to sink vertices
+
+    saturateSrcArcs();
+    bool isComplete = discharge();
+
+    // phase 2: return excess that can't reach sink to src vertices.
+    // excess absorbed by sink vertices is the flow value and is dropped
+
+    if(isComplete)
+    {
+        threadPool_.parallelFor(vtxCount_, [&](int, size_t beg, size_t end)
+        {
+            for(size_t v = beg; v < end; ++v)
+            {
+                if(graph.isSrc(Index(v)))
+                    roles_[v] = Target;
+                else
+                {
+                    roles_[v] = Inner;
+                    if(graph.isSink(Index(v)))
+                        excesses_[v].store(0, RELAXED);
+                }
+            }
+        });
+
+        isReturning_ = true;
+        isComplete = discharge();
+    }
+
+    MinCutResult &ret = result_;
+    ret.reachableVertices.assign(vtxCount_, false);
+
+    if(isComplete)
+    {
+        // now the preflow is a max flow, and src vertices are the targets
+
+        computeLabels(false);
+
+        for(int v = 0; v < vtxCount_; ++v)
+        {
+            if(labels_[v].load(RELAXED) < maxLabel_)
+                ret.reachableVertices.set(v);
+        }
+    }
+    else
+    {
+        // phase 2 never changes whether a vertex can reach sink
+
+        resetRoles();
+        computeLabels(true);
+
+        for(int v = 0; v < vtxCount_; ++v)
+        {
+            if(labels_[v].load(RELAXED) >= maxLabel_)
+                ret.reachableVertices.set(v);
+        }
+    }
+
+    findCutEdges(graph, ret);
+
+    graph_ = nullptr;
+    return ret;
+}
+
+void PushRelabelSolver::init(const Graph &graph)
+{
+    graph_    = &graph;
+    vtxCount_ = int(graph.getVertexCount());
+    maxLabel_ = vtxCount_ + 1;
+
+    const Index edgeCount = graph.getEdgeCount();
+
+    // vectors of atomics can't be resized in place, so they are reallocated
+    // only when too small, and may be longer than the graph needs
+
+    auto reserve = [](auto &arr, size_t size)
+    {
+        if(arr.size() < size)
+            arr = std::decay_t<decltype(arr)>(size);
+    };
+
+    roles_.resize(vtxCount_);
+    reserve(residuals_, 2 * size_t(edgeCount));
+    reserve(excesses_, vtxCount_);
+    reserve(labels_, vtxCount_);
+    reserve(labelCounts_, maxLabel_ + 1);
+    reserve(isQueued_, vtxCount_);
+    newLabels_.resize(vtxCount_);
+    srcLinkFlows_.resize(vtxCount_);
+    sinkLinkRes_.resize(vtxCount_);
+
+    localActiveLists_.resize(threadPool_.getThreadCount());
+    localRelabelLists_.resize(threadPool_.getThreadCount());
+
+    threadPool_.parallelFor(edgeCount, [&](int, size_t beg, size_t end)
+    {
+        for(size_t e = beg; e < end; ++e)
+        {
+            const int cap = graph.hasEdge(Index(e)) ?
+                            graph.getEdgeCapacity(Index(e)) : 0;
+            residuals_[2 * e].store(cap, RELAXED);
+            residuals_[2 * e + 1].store(cap, RELAXED);
+        }
+    });
+
+    threadPool_.parallelFor(vtxCount_, [&](int, size_t beg, size_t end)
+    {
+        for(size_t v = beg; v < end; ++v)
+        {
+            excesses_[v].store(0, RELAXED);
+            isQueued_[v].store(false, RELAXED);
+        }
+    });
+
+    resetRoles();
+}
+
+void PushRelabelSolver::resetRoles()
+{
+    threadPool_.parallelFor(vtxCount_, [&](int, size_t beg, size_t end)
+    {
+        for(size_t v = beg; v < end; ++v)
+        {
+            if(graph_->isSrc(Index(v)))
+                roles_[v] = Source;
+            else if(graph_->isSink(Index(v)))
+                roles_[v] = Target;
+            else
+                roles_[v] = Inner;
+        }
+    });
+
+    isReturning_ = false;
+}
+
+void PushRelabelSolver::saturateSrcArcs()
+{
+    threadPool_.parallelFor(vtxCount_, [&](int, size_t beg, size_t end)
+    {
+        for(size_t v = beg; v < end; ++v)
+        {
+            if(roles_[v] == Inner)
+            {
+                const int cap = graph_->getTerminalCapacity(Index(v));
+                srcLinkFlows_[v] = std::max(cap, 0);
+                sinkLinkRes_[v]  = std::max(-cap, 0);
+                if(cap > 0)
+                    excesses_[v].fetch_add(cap, RELAXED);
+                continue;
+            }
+
+            srcLinkFlows_[v] = 0;
+            sinkLinkRes_[v]  = 0;
+
+            if(roles_[v] != Source)
+                continue;
+
+            graph_->forEachArc(Index(v), [&](Index arc, Index u)
+            {
+                const int res = residuals_[arc].load(RELAXED);
+                if(roles_[u] != Source && res > 0)
+                {
+                    residuals_[arc].fetch_sub(res, RELAXED);
+                    residuals_[Graph::getSisterArc(arc)].fetch_add(
+                        res, RELAXED);
+                    excesses_[u].fetch_add(res, RELAXED);
+                }
+                return false;
+            });
+        }
+    });
+}
+
+int &PushRelabelSolver::getTargetLinkRes(Index v) noexcept
+{
+    return isReturning_ ? srcLinkFlows_[v] : sinkLinkRes_[v];
+}
+
+int PushRelabelSolver::getReversedTargetLinkRes(Index v) const noexcept
+{
+    const int cap = graph_->getTerminalCapacity(v);
+    if(isReturning_)
+        return cap > 0 ? cap - srcLinkFlows_[v] : 0;
+    return cap < 0 ? -cap - sinkLinkRes_[v] : 0;
+}
+
+bool PushRelabelSolver::discharge()
+{
+    computeLabels(true);
+    collectActiveVertices();
+
+    while(!activeVtces_.empty())
+    {
+        if(isPastDeadline())
+            return false;
+
+        if(relabelCount_ >= GLOBAL_RELABEL_FREQ * vtxCount_)
+        {
+            computeLabels(true);
+            activeVtces_.erase(
+                std::remove_if(
+                    activeVtces_.begin(), activeVtces_.end(), [&](Index v)
+                {
+                    return labels_[v].load(RELAXED) >= maxLabel_;
+                }),
+                activeVtces_.end());
+        }
+
+        pushRound();
+        relabelRound();
+        applyLabels();
+
+        // vertices pushed into or with remaining excess
+
+        mergeLocalLists(localActiveLists_, activeVtces_);
+        activeVtces_.erase(
+            std::remove_if(
+                activeVtces_.begin(), activeVtces_.end(), [&](Index v)
+            {
+                isQueued_[v].store(false, RELAXED);
+                return labels_[v].load(RELAXED) >= maxLabel_;
+            }),
+            activeVtces_.end());
+    }
+
+    return true;
+}
+
+void PushRelabelSolver::computeLabels(bool reversed)
+{
+    // targets form the first frontier. vertices with t-links to the
+    // terminal of targets join the second one
+
+    threadPool_.parallelFor(
+        vtxCount_, [&](int threadIndex, size_t beg, size_t end)
+    {
+        auto &frontier = localActiveLists_[threadIndex];
+        auto &linked   = localRelabelLists_[threadIndex];
+        for(size_t v = beg; v < end; ++v)
+        {
+            const int linkRes = roles_[v] != Inner ? 0 :
+                                reversed ? getTargetLinkRes(Index(v)) :
+                                           getReversedTargetLinkRes(Index(v));
+            if(roles_[v] == Target)
+            {
+                labels_[v].store(0, RELAXED);
+                frontier.push_back(Index(v));
+            }
+            else if(linkRes > 0)
+            {
+                labels_[v].store(1, RELAXED);
+                linked.push_back(Index(v));
+            }
+            else
+                labels_[v].store(maxLabel_, RELAXED);
+        }
+    });
+
+    threadPool_.parallelFor(maxLabel_ + 1, [&](int, size_t beg, size_t end)
+    {
+        for(size_t i = beg; i < end; ++i)
+            labelCounts_[i].store(0, RELAXED);
+    });
+
+    mergeLocalLists(localActiveLists_, frontier_);
+
+    // level-synchronous bfs. each vertex is claimed by exactly one thread
+
+    // the second frontier may consist of linked vertices only
+
+    for(int label = 1;
+        label < maxLabel_ && (label == 1 || !frontier_.empty()); ++label)
+    {
+        threadPool_.parallelFor(
+            frontier_.size(), [&](int threadIndex, size_t beg, size_t end)
+        {
+            auto &nextFrontier = localActiveLists_[threadIndex];
+            for(size_t i = beg; i < end; ++i)
+            {
+                graph_->forEachArc(frontier_[i], [&](Index arc, Index u)
+                {
+                    const Index resArc = reversed ?
+                                         Graph::getSisterArc(arc) : arc;
+                    if(roles_[u] != Inner ||
+                       residuals_[resArc].load(RELAXED) <= 0)
+                        return false;
+
+                    int expected = maxLabel_;
+                    if(labels_[u].load(RELAXED) == maxLabel_ &&
+                       labels_[u].compare_exchange_strong(
+                           expected, label, RELAXED))
+                        nextFrontier.push_back(u);
+
+                    return false;
+                });
+            }
+        });
+
+        if(label == 1)
+        {
+            for(size_t i = 0; i < localActiveLists_.size(); ++i)
+            {
+                auto &linked = localRelabelLists_[i];
+                localActiveLists_[i].insert(
+                    localActiveLists_[i].end(), linked.begin(), linked.end());
+                linked.clear();
+            }
+        }
+
+        mergeLocalLists(localActiveLists_, frontier_);
+        labelCounts_[label].store(int(frontier_.size()), RELAXED);
+    }
+
+    relabelCount_ = 0;
+}
+
+void PushRelabelSolver::collectActiveVertices()
+{
+    threadPool_.parallelFor(
+        vtxCount_, [&](int threadIndex, size_t beg, size_t end)
+    {
+        auto &active = localActiveLists_[threadIndex];
+        for(size_t v = beg; v < end; ++v)
+        {
+            if(roles_[v] == Inner &&
+               excesses_[v].load(RELAXED) > 0 &&
+               labels_[v].load(RELAXED) < maxLabel_)
+                active.push_back(Index(v));
+        }
+    });
+
+    mergeLocalLists(localActiveLists_, activeVtces_);
+}
+
+void PushRelabelSolver::pushRound()
+{
+    /*
+     * v -> u is admissible iff label(v) == label(u) + 1, so u never pushes
+     * along u -> v in the same round, and concurrent pushes of v & u never
+     * touch the same arc
+     */
+
+    threadPool_.parallelFor(
+        activeVtces_.size(), [&](int threadIndex, size_t beg, size_t end)
+    {
+        auto &nextActive = localActiveLists_[threadIndex];
+        auto &relabeled  = localRelabelLists_[threadIndex];
+
+        for(size_t i = beg; i < end; ++i)
+        {
+            const Index v     = activeVtces_[i];
+            const int   label = labels_[v].load(RELAXED);
+            const int   oldExcess = excesses_[v].load(RELAXED);
+
+            int excess = oldExcess;
+
+            int &linkRes = getTargetLinkRes(v);
+            if(label == 1 && linkRes > 0)
+            {
+                const int delta = std::min(excess, linkRes);
+                linkRes -= delta;
+                excess  -= delta;
+            }
+
+            if(excess > 0)
+            {
+                graph_->forEachArc(v, [&](Index arc, Index u)
+                {
+                    if(labels_[u].load(RELAXED) != label - 1)
+                        return false;
+
+                    const int res = residuals_[arc].load(RELAXED);
+                    if(res <= 0)
+                        return false;
+
+                    const int delta = std::min(excess, res);
+                    residuals_[arc].fetch_sub(delta, RELAXED);
+                    residuals_[Graph::getSisterArc(arc)].fetch_add(
+                        delta, RELAXED);
+
+                    if(roles_[u] == Inner)
+                    {
+                        excesses_[u].fetch_add(delta, RELAXED);
+                        if(!isQueued_[u].exchange(true, RELAXED))
+                            nextActive.push_back(u);
+                    }
+
+                    excess -= delta;
+                    return excess == 0;
+                });
+            }
+
+            excesses_[v].fetch_sub(oldExcess - excess, RELAXED);
+
+            // all admissible arcs are saturated
+            if(excess > 0)
+            {
+                relabeled.push_back(v);
+                if(!isQueued_[v].exchange(true, RELAXED))
+                    nextActive.push_back(v);
+            }
+        }
+    });
+
+    mergeLocalLists(localRelabelLists_, relabeledVtces_);
+}
+
+void PushRelabelSolver::relabelRound()
+{
+    // labels are read-only here. new ones are applied in applyLabels
+
+    threadPool_.parallelFor(
+        relabeledVtces_.size(), [&](int, size_t beg, size_t end)
+    {
+        for(size_t i = beg; i < end; ++i)
+        {
+            const Index v = relabeledVtces_[i];
+
+            int minLabel = getTargetLinkRes(v) > 0 ? 0 : maxLabel_ - 1;
+            graph_->forEachArc(v, [&](Index arc, Index u)
+            {
+                if(residuals_[arc].load(RELAXED) > 0)
+                    minLabel = std::min(minLabel, labels_[u].load(RELAXED));
+                return false;
+            });
+
+            newLabels_[v] = minLabel + 1;
+        }
+    });
+}
+
+void PushRelabelSolver::applyLabels()
+{
+    gap_.store(maxLabel_, RELAXED);
+
+    threadPool_.parallelFor(
+        relabeledVtces_.size(), [&](int, size_t beg, size_t end)
+    {
+        for(size_t i = beg; i < end; ++i)
+        {
+            const Index v        = relabeledVtces_[i];
+            const int   oldLabel = labels_[v].load(RELAXED);
+            const int   newLabel = newLabels_[v];
+
+            labels_[v].store(newLabel, RELAXED);
+            if(newLabel < maxLabel_)
+                labelCounts_[newLabel].fetch_add(1, RELAXED);
+
+            // a level may become empty only temporarily. checked below
+            if(labelCounts_[oldLabel].fetch_sub(1, RELAXED) == 1)
+            {
+                int gap = gap_.load(RELAXED);
+                while(oldLabel < gap &&
+                      !gap_.compare_exchange_weak(gap, oldLabel, RELAXED))
+                    ;
+            }
+        }
+    });
+
+    relabelCount_ += int(relabeledVtces_.size());
+
+    const int gap = gap_.load(RELAXED);
+    if(gap < maxLabel_ && !labelCounts_[gap].load(RELAXED))
+        liftGap(gap);
+}
+
+void PushRelabelSolver::liftGap(int gap)
+{
+    // vertices above an empty level can't reach any target
+
+    threadPool_.parallelFor(vtxCount_, [&](int, size_t beg, size_t end)
+    {
+        for(size_t v = beg; v < end; ++v)
+        {
+            const int label = labels_[v].load(RELAXED);
+            if(roles_[v] == Inner && gap < label && label < maxLabel_)
+                labels_[v].store(maxLabel_, RELAXED);
+        }
+    });
+
+    threadPool_.parallelFor(
+        maxLabel_ - gap - 1, [&](int, size_t beg, size_t end)
+    {
+        for(size_t i = beg; i < end; ++i)
+            labelCounts_[gap + 1 + i].store(0, RELAXED);
+    });
+}
+
+void PushRelabelSolver::mergeLocalLists(
+    std::vector<std::vector<Index>> &localLists,
+    std::vector<Index>              &dst)
+{
+    dst.clear();
+    for(auto &list : localLists)
+    {
+        dst.insert(dst.end(), list.begin(), list.end());
+        list.clear();
+    }
+}
+
+GCTS_END
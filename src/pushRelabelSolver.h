@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "maxFlowSolver.h"
+#include "threadPool.h"
+
+GCTS_BEGIN
+
+// multi-threaded push-relabel. excess left after the max preflow is returned
+// to src vertices, so that the cut is the same as BKSolver's
+class PushRelabelSolver : public MaxFlowSolver
+{
+public:
+
+    using Index = Graph::Index;
+
+    explicit PushRelabelSolver(ThreadPool &threadPool) noexcept;
+
+    const MinCutResult &findMinCut(const Graph &graph) override;
+
+private:
+
+    static constexpr std::memory_order RELAXED = std::memory_order_relaxed;
+
+    // global relabeling is triggered after GLOBAL_RELABEL_FREQ * V relabels
+    static constexpr int GLOBAL_RELABEL_FREQ = 1;
+
+    enum Role : std::uint8_t
+    {
+        Inner,
+        Source, // excess is never pushed from / into it
+        Target, // absorbs all excess pushed into it
+    };
+
+    void init(const Graph &graph);
+
+    // src vertices are sources and sink vertices are targets
+    void resetRoles();
+
+    // also saturates finite src t-links
+    void saturateSrcArcs();
+
+    // residual of the t-link arc from v to the terminal of targets
+    int &getTargetLinkRes(Index v) noexcept;
+
+    // residual of the t-link arc from the terminal of targets to v
+    int getReversedTargetLinkRes(Index v) const noexcept;
+
+    // run rounds until there is no active vertex. returns false if stopped
+    // by the deadline
+    bool discharge();
+
+    // distance to/from targets in the residual graph. maxLabel_ if there is
+    // no path
+    void computeLabels(bool reversed);
+
+    void collectActiveVertices();
+
+    void pushRound();
+
+    void relabelRound();
+
+    void applyLabels();
+
+    void liftGap(int gap);
+
+    // move elements of thread-local lists into dst
+    static void mergeLocalLists(
+        std::vector<std::vector<Index>> &localLists,
+        std::vector<Index>              &dst);
+
+    ThreadPool &threadPool_;
+
+    const Graph *graph_ = nullptr;
+    int vtxCount_ = 0;
+
+    // label of vertices that can't reach targets. the terminal of targets
+    // counts as a vertex on paths to them
+    int maxLabel_ = 0;
+
+    std::vector<Role> roles_;
+
+    std::vector<std::atomic<int>> residuals_; // indexed by arc
+    std::vector<std::atomic<int>> excesses_;
+    std::vector<std::atomic<int>> labels_;
+    std::vector<std::atomic<int>> labelCounts_;
+    std::vector<std::atomic<bool>> isQueued_;
+
+    std::vector<int> newLabels_;
+
+    // finite t-links. accessed only by the thread processing the vertex
+    std::vector<int> srcLinkFlows_;
+    std::vector<int> sinkLinkRes_;
+
+    // whether excess is being returned to src, i.e. in phase 2
+    bool isReturning_ = false;
+
+    std::vector<Index> activeVtces_;
+    std::vector<Index> relabeledVtces_;
+    std::vector<Index> frontier_;
+
+    // indexed by thread
+    std::vector<std::vector<Index>> localActiveLists_;
+    std::vector<std::vector<Index>> localRelabelLists_;
+
+    int relabelCount_ = 0;
+    std::atomic<int> gap_ = 0;
+};
+
+GCTS_END
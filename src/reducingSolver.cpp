@@ -0,0 +1,231 @@
+#include <algorithm>
+
+#include "reducingSolver.h"
+
+GCTS_BEGIN
+
+ReducingSolver::ReducingSolver(std::unique_ptr<MaxFlowSolver> solver) noexcept
+    : solver_(std::move(solver))
+{
+
+}
+
+void ReducingSolver::setDeadline(Clock::time_point deadline) noexcept
+{
+    solver_->setDeadline(deadline);
+}
+
+const MinCutResult &ReducingSolver::findMinCut(const Graph &graph)
+{
+    if(!reduce(graph))
+        return expand(graph, nullptr);
+
+    return expand(graph, &solver_->findMinCut(reduced_));
+}
+
+bool ReducingSolver::reduce(const Graph &graph)
+{
+    // copy assignment reuses the storage of reduced_
+    reduced_ = graph;
+
+    const Index vtxCount = graph.getVertexCount();
+
+    degrees_.assign(vtxCount, 0);
+    leaves_.clear();
+    isResolved_.assign(vtxCount, false);
+    isResolvedToSrc_.assign(vtxCount, false);
+
+    removeZeroEdges();
+    eliminateLeaves();
+    resolveOneSidedComponents();
+
+    return std::any_of(
+        degrees_.begin(), degrees_.end(), [](Index d) { return d > 0; });
+}
+
+void ReducingSolver::removeZeroEdges()
+{
+    // zero capacity edges never carry flow, so their residual capacities are
+    // always zero
+
+    const Index edgeCount = reduced_.getEdgeCount();
+    for(Index e = 0; e < edgeCount; ++e)
+    {
+        if(!reduced_.hasEdge(e))
+            continue;
+
+        if(!reduced_.getEdgeCapacity(e))
+        {
+            reduced_.removeEdge(e);
+            continue;
+        }
+
+        ++degrees_[reduced_.getEdgeA(e)];
+        ++degrees_[reduced_.getEdgeB(e)];
+    }
+}
+
+void ReducingSolver::eliminateLeaves()
+{
+    stack_.clear();
+    for(Index v = 0; v < reduced_.getVertexCount(); ++v)
+    {
+        if(degrees_[v] == 1)
+            stack_.push_back(v);
+    }
+
+    while(!stack_.empty())
+    {
+        const Index v = stack_.back();
+        stack_.pop_back();
+
+        if(degrees_[v] != 1)
+            continue;
+
+        Index edge = Graph::NIL, neighbor = Graph::NIL;
+        reduced_.forEachArc(v, [&](Index arc, Index u)
+        {
+            edge     = Graph::getArcEdge(arc);
+            neighbor = u;
+            return true;
+        });
+
+        // src -> v -> neighbor carries at most min(t, c), as does a src ->
+        // neighbor t-link with that capacity. same for sink
+
+        const int c = reduced_.getEdgeCapacity(edge);
+        const int t = reduced_.getTerminalCapacity(v);
+
+        const bool isHard = reduced_.isSrc(v) || reduced_.isSink(v);
+        const int delta = isHard ? (t > 0 ? c : -c) :
+                          t > 0  ? std::min(t, c) : -std::min(-t, c);
+
+        if(!reduced_.isSrc(neighbor) && !reduced_.isSink(neighbor))
+        {
+            reduced_.setTerminalCapacity(
+                neighbor, reduced_.getTerminalCapacity(neighbor) + delta);
+        }
+
+        // hard vertices are left to the solver as isolated ones
+
+        if(!isHard)
+        {
+            leaves_.push_back({ v, neighbor, c, t });
+            reduced_.setTerminalCapacity(v, 0);
+        }
+
+        reduced_.removeEdge(edge);
+        degrees_[v] = 0;
+        if(--degrees_[neighbor] == 1)
+            stack_.push_back(neighbor);
+    }
+}
+
+void ReducingSolver::resolveOneSidedComponents()
+{
+    // components with no sink t-link are reachable from src as long as one
+    // vertex has a src t-link, and vice versa
+
+    const Index vtxCount = reduced_.getVertexCount();
+    isVisited_.assign(vtxCount, false);
+
+    for(Index s = 0; s < vtxCount; ++s)
+    {
+        if(isVisited_[s])
+            continue;
+
+        if(!degrees_[s] && !reduced_.getTerminalCapacity(s))
+            continue;
+
+        component_.clear();
+        stack_.clear();
+
+        stack_.push_back(s);
+        isVisited_.set(s);
+
+        bool hasSrcLink = false, hasSinkLink = false;
+        while(!stack_.empty())
+        {
+            const Index v = stack_.back();
+            stack_.pop_back();
+            component_.push_back(v);
+
+            hasSrcLink  |= reduced_.getTerminalCapacity(v) > 0;
+            hasSinkLink |= reduced_.getTerminalCapacity(v) < 0;
+
+            reduced_.forEachArc(v, [&](Index, Index u)
+            {
+                if(!isVisited_[u])
+                {
+                    isVisited_.set(u);
+                    stack_.push_back(u);
+                }
+                return false;
+            });
+        }
+
+        if(hasSrcLink && hasSinkLink)
+            continue;
+
+        for(Index v : component_)
+        {
+            reduced_.forEachArc(v, [&](Index arc, Index)
+            {
+                reduced_.removeEdge(Graph::getArcEdge(arc));
+                return false;
+            });
+
+            degrees_[v] = 0;
+
+            isResolved_.set(v);
+            isResolvedToSrc_.set(v, hasSrcLink);
+
+            if(!reduced_.isSrc(v) && !reduced_.isSink(v))
+                reduced_.setTerminalCapacity(v, 0);
+        }
+    }
+}
+
+const MinCutResult &ReducingSolver::expand(
+    const Graph &graph, const MinCutResult *reducedCut)
+{
+    MinCutResult &ret = result_;
+
+    const Index vtxCount = graph.getVertexCount();
+    ret.reachableVertices.assign(vtxCount, false);
+
+    for(Index v = 0; v < vtxCount; ++v)
+    {
+        bool isReachable;
+        if(isResolved_[v])
+            isReachable = isResolvedToSrc_[v];
+        else if(reducedCut)
+            isReachable = reducedCut->reachableVertices[v];
+        else
+            isReachable = reduced_.getTerminalCapacity(v) > 0;
+
+        if(isReachable)
+            ret.reachableVertices.set(v);
+    }
+
+    // a leaf is reachable through its neighbor, or through its own src
+    // t-link when the edge is not saturated by it
+
+    for(auto it = leaves_.rbegin(); it != leaves_.rend(); ++it)
+    {
+        const bool isNeighborReachable = ret.reachableVertices[it->neighbor];
+        const int c = it->edgeCapacity, t = it->terminalCapacity;
+
+        const bool isReachable =
+            t > 0 ? isNeighborReachable || c < t  :
+            t < 0 ? isNeighborReachable && c > -t :
+                    isNeighborReachable;
+
+        ret.reachableVertices.set(it->v, isReachable);
+    }
+
+    findCutEdges(graph, ret);
+    return ret;
+}
+
+GCTS_END
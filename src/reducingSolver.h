@@ -0,0 +1,62 @@
+#pragma once
+
+#include "maxFlowSolver.h"
+
+GCTS_BEGIN
+
+// removes zero edges, leaves & one-sided components before calling the
+// wrapped solver. the cut is the same as without reduction
+class ReducingSolver : public MaxFlowSolver
+{
+public:
+
+    using Index = Graph::Index;
+
+    explicit ReducingSolver(std::unique_ptr<MaxFlowSolver> solver) noexcept;
+
+    void setDeadline(Clock::time_point deadline) noexcept override;
+
+    const MinCutResult &findMinCut(const Graph &graph) override;
+
+private:
+
+    struct Leaf
+    {
+        Index v;
+        Index neighbor;
+        int   edgeCapacity;
+        int   terminalCapacity;
+    };
+
+    // reduce graph into reduced_. returns whether any edge is left
+    bool reduce(const Graph &graph);
+
+    void removeZeroEdges();
+
+    void eliminateLeaves();
+
+    void resolveOneSidedComponents();
+
+    // map the cut of reduced_ back to graph. reducedCut is nullptr when
+    // there is no edge left in reduced_
+    const MinCutResult &expand(
+        const Graph &graph, const MinCutResult *reducedCut);
+
+    std::unique_ptr<MaxFlowSolver> solver_;
+
+    Graph reduced_;
+
+    std::vector<Index> degrees_;
+    std::vector<Index> stack_;
+
+    std::vector<Leaf> leaves_; // in order of elimination
+
+    // vertices of one-sided components
+    Bitmap isResolved_;
+    Bitmap isResolvedToSrc_;
+
+    Bitmap isVisited_;
+    std::vector<Index> component_;
+};
+
+GCTS_END
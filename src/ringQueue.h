@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cassert>
+#include <vector>
+
+#include "synthesizer.h"
+
+GCTS_BEGIN
+
+/*
+ * FIFO queue in a growable ring buffer. unlike std::deque, storage is never
+ * released, so a queue that is filled & drained repeatedly stops allocating
+ * once it has reached its peak size
+ */
+template<typename T>
+class RingQueue
+{
+public:
+
+    bool empty() const noexcept
+    {
+        return size_ == 0;
+    }
+
+    size_t size() const noexcept
+    {
+        return size_;
+    }
+
+    void clear() noexcept
+    {
+        head_ = 0;
+        size_ = 0;
+    }
+
+    const T &front() const noexcept
+    {
+        assert(!empty());
+        return buffer_[head_];
+    }
+
+    void push_back(const T &value)
+    {
+        if(size_ == buffer_.size())
+            grow();
+        buffer_[(head_ + size_) & (buffer_.size() - 1)] = value;
+        ++size_;
+    }
+
+    void pop_front() noexcept
+    {
+        assert(!empty());
+        head_ = (head_ + 1) & (buffer_.size() - 1);
+        --size_;
+    }
+
+private:
+
+    // capacity is always a power of 2
+    void grow()
+    {
+        std::vector<T> newBuffer(buffer_.empty() ? 64 : 2 * buffer_.size());
+        for(size_t i = 0; i < size_; ++i)
+            newBuffer[i] = buffer_[(head_ + i) & (buffer_.size() - 1)];
+
+        buffer_ = std::move(newBuffer);
+        head_   = 0;
+    }
+
+    std::vector<T> buffer_;
+    size_t head_ = 0;
+    size_t size_ = 0;
+};
+
+GCTS_END
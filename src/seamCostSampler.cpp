@@ -0,0 +1,67 @@
+#include <cassert>
+
+#include "seamCostSampler.h"
+
+GCTS_BEGIN
+
+SeamCostSampler::SeamCostSampler(const Int2 &size)
+    : width_(size.x),
+      xSeamCosts_(size_t(size.x) * size.y, 0),
+      ySeamCosts_(xSeamCosts_.size(), 0),
+      costs_(xSeamCosts_.size(), 0),
+      tree_(costs_.size() + 1, 0)
+{
+    topStep_ = 1;
+    while(topStep_ * 2 <= costs_.size())
+        topStep_ *= 2;
+}
+
+void SeamCostSampler::setSeamCost(
+    const Int2 &position, bool isHori, int cost) noexcept
+{
+    const size_t i = size_t(position.y) * width_ + position.x;
+
+    int &seamCost = (isHori ? xSeamCosts_ : ySeamCosts_)[i];
+    const int delta = cost - seamCost;
+    if(!delta)
+        return;
+    seamCost = cost;
+    costs_[i] += delta;
+
+    for(size_t j = i + 1; j < tree_.size(); j += j & (~j + 1))
+        tree_[j] += delta;
+}
+
+int64_t SeamCostSampler::getTotalCost() const noexcept
+{
+    int64_t ret = 0;
+    for(size_t j = costs_.size(); j > 0; j -= j & (~j + 1))
+        ret += tree_[j];
+    return ret;
+}
+
+Int2 SeamCostSampler::sample(std::default_random_engine &rng) const
+{
+    assert(getTotalCost() > 0);
+
+    std::uniform_int_distribution<int64_t> dis(0, getTotalCost() - 1);
+    int64_t target = dis(rng);
+
+    // descend to the last texel whose prefix sum is not greater than target.
+    // the sampled texel is the next one
+
+    size_t i = 0;
+    for(size_t step = topStep_; step > 0; step >>= 1)
+    {
+        if(i + step < tree_.size() && tree_[i + step] <= target)
+        {
+            i += step;
+            target -= tree_[i];
+        }
+    }
+
+    assert(i < costs_.size() && costs_[i] > 0);
+    return { int(i % width_), int(i / width_) };
+}
+
+GCTS_END
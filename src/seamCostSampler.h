@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "synthesizer.h"
+
+GCTS_BEGIN
+
+/*
+ * samples output texels with probability proportional to the cost of the
+ * seams they hold.
+ *
+ * costs are kept in a fenwick tree over texels in row-major order, so both
+ * updating a cost and sampling take O(log n).
+ */
+class SeamCostSampler
+{
+public:
+
+    explicit SeamCostSampler(const Int2 &size);
+
+    // cost of the seam between the texel and its +x/+y neighbor
+    void setSeamCost(const Int2 &position, bool isHori, int cost) noexcept;
+
+    int64_t getTotalCost() const noexcept;
+
+    // total cost must be positive
+    Int2 sample(std::default_random_engine &rng) const;
+
+private:
+
+    int width_ = 0;
+
+    std::vector<int>     xSeamCosts_;
+    std::vector<int>     ySeamCosts_;
+    std::vector<int>     costs_; // of both seams of each texel
+    std::vector<int64_t> tree_;  // 1-based
+
+    // highest power of 2 not greater than texel count
+    size_t topStep_ = 0;
+};
+
+GCTS_END
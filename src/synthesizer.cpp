@@ -1,25 +1,71 @@
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <numeric>
+#include <shared_mutex>
+
 #include <agz/utility/alloc.h>
 #include <agz/utility/console.h>
 
+#include "allocationCounter.h"
 #include "graphBuilder.h"
+#include "holeTracker.h"
+#include "maxFlowSolver.h"
+#include "patchMatcher.h"
+#include "seamCostSampler.h"
+#include "texelPlanes.h"
+#include "threadPool.h"
 
 GCTS_BEGIN
 
 void Synthesizer::setParams(
     const Int2            &patchSize,
     int                    additionalPatchCount,
-    PatchPlacementStrategy patchPlacement) noexcept
+    PatchPlacementStrategy patchPlacement,
+    MaxFlowSolverType      maxFlowSolver,
+    int                    timeBudgetMs) noexcept
 {
     patchSize_            = patchSize;
     additionalPatchCount_ = additionalPatchCount;
     patchPlacement_       = patchPlacement;
+    maxFlowSolver_        = maxFlowSolver;
+    timeBudgetMs_         = timeBudgetMs;
+}
+
+void Synthesizer::setMaxFlowSolverLayers(
+    const MaxFlowSolverLayers &layers) noexcept
+{
+    maxFlowSolverLayers_ = layers;
+}
+
+void Synthesizer::setConvergenceParams(
+    int   windowSize,
+    float minImprovement) noexcept
+{
+    convergenceWindow_    = windowSize;
+    convergenceThreshold_ = minImprovement;
+}
+
+void Synthesizer::setPatchBatchSize(int batchSize) noexcept
+{
+    patchBatchSize_ = batchSize;
+}
+
+void Synthesizer::setCandidateCount(int candidateCount) noexcept
+{
+    candidateCount_ = candidateCount;
+}
+
+void Synthesizer::setOptimisticRefinement(bool enabled) noexcept
+{
+    optimisticRefinement_ = enabled;
 }
 
 Image2D<RGB> Synthesizer::generate(
     const Image2D<RGB> &src,
     const Int2         &dstSize) const
 {
-    Image2D<Texel> texels(dstSize.y, dstSize.x);
+    TexelPlanes texels(dstSize);
     PatchHistory patchHistory;
     std::default_random_engine rng{ std::random_device()() };
 
@@ -28,90 +74,617 @@ Image2D<RGB> Synthesizer::generate(
         std::max(1, (patchSize_.y - 2) / 2)
     };
 
+    // texels holding seams of the last cuts
+    std::vector<Seam> seams;
+
+    HoleTracker holeTracker(dstSize);
+
+    // refinement patches are placed around texels sampled by seam costs
+    SeamCostSampler seamCostSampler(dstSize);
+
+    ThreadPool threadPool;
+    auto solver = wrapMaxFlowSolver(
+        createMaxFlowSolver(maxFlowSolver_, threadPool), maxFlowSolverLayers_);
+
+    using Clock = MaxFlowSolver::Clock;
+
+    // the budget counts from here, but only bounds the solvers once holes
+    // are filled, so that hole filling cuts are always exact
+    const bool hasTimeBudget = timeBudgetMs_ > 0;
+    const auto deadline = Clock::now() +
+                          std::chrono::milliseconds(timeBudgetMs_);
+
+    std::unique_ptr<PatchMatcher> patchMatcher;
+    if(patchPlacement_ != Random)
+        patchMatcher = std::make_unique<PatchMatcher>(src, patchSize_);
+
+    auto pickPatch = [&](const Int2 &patchBeg)
+    {
+        if(!patchMatcher)
+            return pickPatchRandomly(src, rng);
+        return pickPatchByMatching(
+            src, texels, patchHistory, patchBeg, *patchMatcher, rng);
+    };
+
+    int nextPatchIndex = 0;
+
+    // serial solvers of patches cut concurrently, indexed by thread. solvers
+    // using the thread pool by themselves are replaced by BK
+    const MaxFlowSolverType localSolverType =
+        maxFlowSolver_ == MaxFlowSolverType::Dinic ? MaxFlowSolverType::Dinic
+                                                   : MaxFlowSolverType::BK;
+
+    std::vector<std::unique_ptr<MaxFlowSolver>> localSolvers;
+    for(int i = 0; i < threadPool.getThreadCount(); ++i)
+    {
+        localSolvers.push_back(wrapMaxFlowSolver(
+            createMaxFlowSolver(localSolverType, threadPool),
+            maxFlowSolverLayers_));
+    }
+
+    auto markHolesFilled = [&](const Int2 &patchBeg)
+    {
+        // holes can only be filled inside the patch
+
+        const Int2 patchEnd = patchBeg + patchSize_;
+        for(int y = std::max(patchBeg.y, 0);
+            y < std::min(patchEnd.y, dstSize.y); ++y)
+        {
+            for(int x = std::max(patchBeg.x, 0);
+                x < std::min(patchEnd.x, dstSize.x); ++x)
+            {
+                if(texels.getPatchIndex(y, x) >= 0)
+                    holeTracker.markFilled({ x, y });
+            }
+        }
+    };
+
+    // assign texels covered by the new patch & src side texels to it
+    auto applyMinCut = [&](
+        const GraphBuilder &graphBuilder,
+        const Graph        &cutGraph,
+        const MinCutResult &minCut,
+        int                 patchIndex)
+    {
+        for(auto &[x, y] : graphBuilder.getNewTexels())
+            texels.setPatchIndex(y, x, patchIndex);
+
+        for(Graph::Index v = 0; v < cutGraph.getVertexCount(); ++v)
+        {
+            if(minCut.reachableVertices[v] &&
+               cutGraph.getVertexType(v) == Graph::VertexType::Texel)
+            {
+                const auto [x, y] = cutGraph.getVertexPosition(v);
+                texels.setPatchIndex(y, x, patchIndex);
+            }
+        }
+    };
+
+    // storage of an iteration, indexed by thread. reused by all iterations
+    // so that they don't allocate in steady state
+    struct Workspace
+    {
+        GraphBuilder          graphBuilder;
+        Graph                 graph;
+        std::vector<Seam>     newSeams;
+        std::vector<uint32_t> seenVersions; // of tiles, by optimistic workers
+    };
+
+    std::vector<Workspace> workspaces(threadPool.getThreadCount());
+
     auto runIter = [&](
         const ImageView2D<RGB> &patch,
         const Int2             &patchBeg,
         int                     patchIndex)
     {
+        auto &workspace = workspaces[0];
+
         // update patch history
 
         patchHistory.addNewPatch(patch, patchBeg);
 
         // build texel graph
 
-        GraphBuilder graphBuilder;
-
-        auto graph = graphBuilder.build(
-            texels, patch, patchBeg, overlapSize, patchHistory);
+        workspace.graphBuilder.build(
+            texels, patch, patchIndex, patchBeg, overlapSize, patchHistory,
+            workspace.graph);
 
         // find min cut
 
-        auto minCut = graph.findMinCut();
+        const auto &minCut = solver->findMinCut(workspace.graph);
 
-        // update texels
+        // update texels & seam info
 
-        for(auto v : minCut.reachableVertices)
+        applyMinCut(
+            workspace.graphBuilder, workspace.graph, minCut, patchIndex);
+        markHolesFilled(patchBeg);
+
+        collectSeams(texels, workspace.graph, minCut, workspace.newSeams);
+        updateSeamInfo(texels, workspace.newSeams, seams);
+        updateSeamCostSampler(
+            texels, patchHistory, patchBeg, patchIndex, seamCostSampler);
+    };
+
+    // patch of a conflict-free set
+    struct ConcurrentIter
+    {
+        ImageView2D<RGB>  patch;
+        Int2              patchBeg;
+        int               patchIndex;
+        std::vector<Seam> seams;
+    };
+
+    std::vector<ConcurrentIter> concurrentIters;
+    std::vector<Seam> batchSeams;
+
+    std::vector<std::vector<int>> placementSets;
+
+    auto runBatch = [&](const std::vector<Int2> &patchBegs)
+    {
+        if(patchBegs.size() == 1)
         {
-            if(v->type == Vertex::Type::Texel)
+            const auto patch = pickPatch(patchBegs.front());
+            runIter(patch, patchBegs.front(), nextPatchIndex++);
+            return;
+        }
+
+        const size_t setCount = partitionPlacements(patchBegs, placementSets);
+        for(size_t setIndex = 0; setIndex < setCount; ++setIndex)
+        {
+            const auto &set = placementSets[setIndex];
+            if(set.size() == 1)
+            {
+                const Int2 &patchBeg = patchBegs[set.front()];
+                const auto patch = pickPatch(patchBeg);
+                runIter(patch, patchBeg, nextPatchIndex++);
+                continue;
+            }
+
+            // patches are picked & recorded in order. each graph cut only
+            // touches texels in its own patch, so the result doesn't depend
+            // on thread timing
+
+            // iters are never shrunk, so that all of them keep their storage.
+            // the first iterCount ones are used
+
+            const size_t iterCount = set.size();
+            if(concurrentIters.size() < iterCount)
+                concurrentIters.resize(iterCount);
+
+            for(size_t i = 0; i < iterCount; ++i)
             {
-                const auto [x, y] = v->position;
-                texels(y, x).patchIndex = patchIndex;
+                auto &iter = concurrentIters[i];
+                iter.patchBeg   = patchBegs[set[i]];
+                iter.patch      = pickPatch(iter.patchBeg);
+                iter.patchIndex = nextPatchIndex++;
+                patchHistory.addNewPatch(iter.patch, iter.patchBeg);
             }
+
+            threadPool.parallelFor(
+                iterCount, [&](int threadIndex, size_t beg, size_t end)
+            {
+                for(size_t i = beg; i < end; ++i)
+                {
+                    auto &iter = concurrentIters[i];
+                    auto &workspace = workspaces[threadIndex];
+
+                    workspace.graphBuilder.build(
+                        texels, iter.patch, iter.patchIndex, iter.patchBeg,
+                        overlapSize, patchHistory, workspace.graph);
+
+                    const auto &minCut =
+                        localSolvers[threadIndex]->findMinCut(workspace.graph);
+
+                    applyMinCut(
+                        workspace.graphBuilder, workspace.graph, minCut,
+                        iter.patchIndex);
+                    collectSeams(texels, workspace.graph, minCut, iter.seams);
+                }
+            }, 1);
+
+            // commit in patch order
+
+            batchSeams.clear();
+            for(size_t i = 0; i < iterCount; ++i)
+            {
+                const auto &iter = concurrentIters[i];
+                markHolesFilled(iter.patchBeg);
+                updateSeamCostSampler(
+                    texels, patchHistory, iter.patchBeg, iter.patchIndex,
+                    seamCostSampler);
+                batchSeams.insert(
+                    batchSeams.end(), iter.seams.begin(), iter.seams.end());
+            }
+
+            updateSeamInfo(texels, batchSeams, seams);
+        }
+    };
+
+    // speculative candidate of the next patch
+    struct Candidate
+    {
+        ImageView2D<RGB> patch;
+        Int2             patchBeg;
+        GraphBuilder     graphBuilder;
+        Graph            graph;
+        MinCutResult     minCut;
+        double           costPerTexel;
+    };
+
+    std::vector<Candidate> candidates;
+
+    auto runCandidates = [&](const std::vector<Int2> &patchBegs)
+    {
+        // candidates are resized rather than cleared to keep their storage
+
+        candidates.resize(patchBegs.size());
+        for(size_t i = 0; i < patchBegs.size(); ++i)
+        {
+            candidates[i].patchBeg = patchBegs[i];
+            candidates[i].patch    = pickPatch(patchBegs[i]);
         }
 
-        // update seam info
+        // candidates share the index of the next patch. graph building
+        // doesn't modify texels, so they don't interfere with each other
+
+        threadPool.parallelFor(
+            candidates.size(),
+            [&](int threadIndex, size_t beg, size_t end)
+        {
+            for(size_t i = beg; i < end; ++i)
+            {
+                auto &c = candidates[i];
+
+                c.graphBuilder.build(
+                    texels, c.patch, nextPatchIndex, c.patchBeg,
+                    overlapSize, patchHistory, c.graph);
+                c.minCut = localSolvers[threadIndex]->findMinCut(c.graph);
+
+                int64_t cutCost = 0;
+                for(auto e : c.minCut.cut)
+                    cutCost += c.graph.getEdgeCapacity(e);
+                for(auto v : c.minCut.cutTerminalLinks)
+                    cutCost += std::abs(c.graph.getTerminalCapacity(v));
+
+                // the cost is spread over texels covered regardless of the
+                // cut: holes, or the patch core once there are none. counting
+                // src side texels as well would favor candidates that
+                // overwrite more of the output for the same seams
+
+                const size_t newTexelCount =
+                    c.graphBuilder.getNewTexels().size();
+                c.costPerTexel = double(cutCost) /
+                                 std::max<size_t>(newTexelCount, 1);
+            }
+        }, 1);
+
+        // commit the cheapest one
+
+        auto &best = *std::min_element(
+            candidates.begin(), candidates.end(),
+            [](const Candidate &lhs, const Candidate &rhs)
+        {
+            return lhs.costPerTexel < rhs.costPerTexel;
+        });
+
+        patchHistory.addNewPatch(best.patch, best.patchBeg);
+        const int patchIndex = nextPatchIndex++;
+
+        applyMinCut(best.graphBuilder, best.graph, best.minCut, patchIndex);
+        markHolesFilled(best.patchBeg);
 
-        updateSeamInfo(texels, minCut.cut);
+        auto &newSeams = workspaces[0].newSeams;
+        collectSeams(texels, best.graph, best.minCut, newSeams);
+        updateSeamInfo(texels, newSeams, seams);
+        updateSeamCostSampler(
+            texels, patchHistory, best.patchBeg, patchIndex, seamCostSampler);
     };
 
+    const int batchSize = std::max(1, patchBatchSize_);
+
     std::cout << "fill holes..." << std::endl;
 
     agz::console::progress_bar_f_t pbar(80, '=');
     pbar.display();
 
-    int nextPatchIndex = 0;
+    // placements of the current batch
+    std::vector<Int2> patchBegs;
 
     for(;;)
     {
-        bool hasHole;
-        Int2 holeBeg;
-
-        const auto patch    = pickPatchRandomly(src, rng);
-        const Int2 patchBeg = pickPatchBegRandomly(
-            texels, rng, &hasHole, &holeBeg);
-
-        if(!hasHole)
+        const Int2 holeBeg = holeTracker.findFirstHole();
+        if(holeBeg.x < 0)
             break;
 
-        runIter(patch, patchBeg, nextPatchIndex++);
+        patchBegs.assign(1, pickPatchBegAround(holeBeg, rng));
 
-        const int holeTexels = holeBeg.y * texels.width() + holeBeg.x;
-        pbar.set_percent(100.0f * holeTexels / texels.size().product());
+        if(candidateCount_ > 1)
+        {
+            while(int(patchBegs.size()) < candidateCount_)
+                patchBegs.push_back(pickPatchBegAround(holeBeg, rng));
+            runCandidates(patchBegs);
+        }
+        else
+        {
+            if(batchSize > 1)
+            {
+                addWavefrontPatchBegs(
+                    holeTracker, holeBeg, dstSize, batchSize, patchBegs, rng);
+            }
+            runBatch(patchBegs);
+        }
+
+        pbar.set_percent(100.0f * holeTracker.getFilledRatio());
         pbar.display();
     }
 
     pbar.done();
 
+    if(hasTimeBudget)
+    {
+        solver->setDeadline(deadline);
+        for(auto &localSolver : localSolvers)
+            localSolver->setDeadline(deadline);
+    }
+
     std::cout << "paste additional patches (" << additionalPatchCount_
               << " in total)..." << std::endl;
 
     pbar = agz::console::progress_bar_f_t(80, '=');
     pbar.display();
 
-    for(int i = 0; i < additionalPatchCount_; ++i)
+    const bool isOptimistic = optimisticRefinement_ && candidateCount_ <= 1;
+
+    // total costs of all seams in the output after each of the last few
+    // batches. the costs fluctuate from patch to patch, so the mean over the
+    // last window is compared with the one over the window before it. each
+    // window covers at least convergenceWindow_ patches
+    const int patchesPerBatch =
+        candidateCount_ > 1 || isOptimistic ? 1 : batchSize;
+    const size_t convergenceWindowBatches =
+        size_t(convergenceWindow_ + patchesPerBatch - 1) / patchesPerBatch;
+
+    std::deque<int64_t> recentSeamCosts;
+
+    // record the seam cost after a batch
+    auto hasConverged = [&]
     {
-        auto patch = pickPatchRandomly(src, rng);
-        const Int2 patchBeg = pickPatchBegRandomly(
-            texels, rng, nullptr, nullptr);
+        if(convergenceWindow_ <= 0)
+            return false;
+
+        recentSeamCosts.push_back(seamCostSampler.getTotalCost());
+        if(recentSeamCosts.size() < 2 * convergenceWindowBatches)
+            return false;
+
+        const auto mid = recentSeamCosts.begin() + convergenceWindowBatches;
+        const int64_t lastSum = std::accumulate(
+            mid, recentSeamCosts.end(), int64_t(0));
+        const int64_t prevSum = std::accumulate(
+            recentSeamCosts.begin(), mid, int64_t(0));
+        recentSeamCosts.pop_front();
+
+        return prevSum - lastSum <= convergenceThreshold_ * prevSum;
+    };
+
+    int pastedCount = 0;
+
+    // high-cost seams anywhere in the output are more likely to be covered.
+    // once all seams are free, patches are placed uniformly
+    auto pickRefinementPatchBeg = [&]
+    {
+        if(seamCostSampler.getTotalCost() > 0)
+            return pickPatchBegAround(seamCostSampler.sample(rng), rng);
+        return pickPatchBegRandomly(dstSize, rng);
+    };
 
-        runIter(patch, patchBeg, nextPatchIndex++);
+    // optimistic refinement. texels, patch history & all other shared states
+    // are read under a shared lock & written under an exclusive one. graphs
+    // are cut without holding the lock. each commit bumps versions of the
+    // tiles it writes, and a commit seeing a tile changed since its graph
+    // building rebuilds the graph against the new texels
+
+    std::shared_mutex sharedStateMutex;
+
+    const int tileCountX = (dstSize.x + VERSION_TILE_SIZE - 1) /
+                           VERSION_TILE_SIZE;
+    const int tileCountY = (dstSize.y + VERSION_TILE_SIZE - 1) /
+                           VERSION_TILE_SIZE;
+    std::vector<uint32_t> tileVersions(size_t(tileCountX) * tileCountY, 0);
+
+    // tiles under the patch dilated by one texel. they cover all texels read
+    // by graph building of the patch & written by its commit
+    auto forEachTileUnder = [&](const Int2 &patchBeg, auto &&func)
+    {
+        const int xBeg = std::max(patchBeg.x - 1, 0) / VERSION_TILE_SIZE;
+        const int yBeg = std::max(patchBeg.y - 1, 0) / VERSION_TILE_SIZE;
+        const int xLast = std::min(
+            patchBeg.x + patchSize_.x, dstSize.x - 1) / VERSION_TILE_SIZE;
+        const int yLast = std::min(
+            patchBeg.y + patchSize_.y, dstSize.y - 1) / VERSION_TILE_SIZE;
+
+        for(int y = yBeg; y <= yLast; ++y)
+        {
+            for(int x = xBeg; x <= xLast; ++x)
+                func(tileVersions[size_t(y) * tileCountX + x]);
+        }
+    };
+
+    int claimedCount = 0;
+    int retryCount   = 0;
+    bool isStopped   = false;
+
+    auto runOptimisticWorker = [&](int threadIndex)
+    {
+        auto &workspace = workspaces[threadIndex];
+        auto &iterGraph = workspace.graph;
+        auto &seenVersions = workspace.seenVersions;
+
+        for(;;)
+        {
+            ImageView2D<RGB> patch;
+            Int2 patchBeg;
+
+            {
+                std::unique_lock lock(sharedStateMutex);
+
+                if(isStopped || claimedCount >= additionalPatchCount_ ||
+                   (hasTimeBudget && Clock::now() >= deadline))
+                    return;
+
+                ++claimedCount;
+                patchBeg = pickRefinementPatchBeg();
+                patch    = pickPatch(patchBeg);
+            }
 
-        pbar.set_percent(100.0f * (i + 1) / additionalPatchCount_);
+            for(;;)
+            {
+                {
+                    std::shared_lock lock(sharedStateMutex);
+
+                    seenVersions.clear();
+                    forEachTileUnder(patchBeg, [&](uint32_t version)
+                    {
+                        seenVersions.push_back(version);
+                    });
+
+                    workspace.graphBuilder.build(
+                        texels, patch, PENDING_PATCH_INDEX, patchBeg,
+                        overlapSize, patchHistory, iterGraph);
+                }
+
+                const auto &minCut =
+                    localSolvers[threadIndex]->findMinCut(iterGraph);
+
+                std::unique_lock lock(sharedStateMutex);
+
+                // patches in flight when stopping are dropped
+                if(isStopped)
+                    return;
+
+                size_t tileIndex = 0;
+                bool isConflicted = false;
+                forEachTileUnder(patchBeg, [&](uint32_t version)
+                {
+                    isConflicted |= version != seenVersions[tileIndex++];
+                });
+
+                if(isConflicted)
+                {
+                    ++retryCount;
+                    continue;
+                }
+
+                // seam costs of the last cut are cleared by this commit
+
+                for(auto &seam : seams)
+                {
+                    const size_t tileX = seam.position.x / VERSION_TILE_SIZE;
+                    const size_t tileY = seam.position.y / VERSION_TILE_SIZE;
+                    ++tileVersions[tileY * tileCountX + tileX];
+                }
+                forEachTileUnder(patchBeg, [](uint32_t &version)
+                {
+                    ++version;
+                });
+
+                patchHistory.addNewPatch(patch, patchBeg);
+                const int patchIndex = nextPatchIndex++;
+
+                applyMinCut(
+                    workspace.graphBuilder, iterGraph, minCut, patchIndex);
+                markHolesFilled(patchBeg);
+
+                collectSeams(texels, iterGraph, minCut, workspace.newSeams);
+                updateSeamInfo(texels, workspace.newSeams, seams);
+                updateSeamCostSampler(
+                    texels, patchHistory, patchBeg, patchIndex,
+                    seamCostSampler);
+
+                ++pastedCount;
+                pbar.set_percent(100.0f * pastedCount / additionalPatchCount_);
+                pbar.display();
+
+                if(hasConverged())
+                    isStopped = true;
+
+                break;
+            }
+        }
+    };
+
+    patchHistory.reserve(
+        size_t(patchHistory.getCurrentIndex() + 1) + additionalPatchCount_);
+
+#ifdef GCTS_COUNT_HEAP_ALLOCATIONS
+    const size_t allocCountBeforePasting = getHeapAllocationCount();
+#endif
+
+    if(isOptimistic)
+    {
+        threadPool.parallelFor(
+            threadPool.getThreadCount(),
+            [&](int threadIndex, size_t beg, size_t end)
+        {
+            for(size_t i = beg; i < end; ++i)
+                runOptimisticWorker(threadIndex);
+        }, 1);
+    }
+
+    while(!isOptimistic && pastedCount < additionalPatchCount_)
+    {
+        if(hasTimeBudget && Clock::now() >= deadline)
+            break;
+
+        if(candidateCount_ > 1)
+        {
+            // candidates compete for the same seam
+
+            const bool hasSeam = seamCostSampler.getTotalCost() > 0;
+            const Int2 seamPos =
+                hasSeam ? seamCostSampler.sample(rng) : Int2();
+
+            patchBegs.resize(candidateCount_);
+            for(auto &patchBeg : patchBegs)
+            {
+                patchBeg = hasSeam ? pickPatchBegAround(seamPos, rng) :
+                                     pickPatchBegRandomly(dstSize, rng);
+            }
+
+            runCandidates(patchBegs);
+            ++pastedCount;
+        }
+        else
+        {
+            patchBegs.resize(
+                std::min(batchSize, additionalPatchCount_ - pastedCount));
+
+            for(auto &patchBeg : patchBegs)
+                patchBeg = pickRefinementPatchBeg();
+
+            runBatch(patchBegs);
+            pastedCount += int(patchBegs.size());
+        }
+
+        pbar.set_percent(100.0f * pastedCount / additionalPatchCount_);
         pbar.display();
+
+        if(hasConverged())
+            break;
     }
 
     pbar.done();
 
+    std::cout << pastedCount << " additional patches pasted. final seam cost: "
+              << seamCostSampler.getTotalCost() << std::endl;
+
+#ifdef GCTS_COUNT_HEAP_ALLOCATIONS
+    std::cout << getHeapAllocationCount() - allocCountBeforePasting
+              << " heap allocations while pasting" << std::endl;
+#endif
+
+    if(isOptimistic)
+        std::cout << retryCount << " conflicting commits retried" << std::endl;
+
     // resolve texels
 
     Image2D<RGB> result(dstSize.y, dstSize.x);
@@ -120,9 +693,9 @@ Image2D<RGB> Synthesizer::generate(
     {
         for(int x = 0; x < dstSize.x; ++x)
         {
-            auto &t = texels(y, x);
-            if(t.patchIndex >= 0)
-                result(y, x) = patchHistory.getRGB(t.patchIndex, x, y);
+            const int patchIndex = texels.getPatchIndex(y, x);
+            if(patchIndex >= 0)
+                result(y, x) = patchHistory.getRGB(patchIndex, x, y);
         }
     }
 
@@ -144,33 +717,85 @@ ImageView2D<RGB> Synthesizer::pickPatchRandomly(
     return src.subview(y, y + patchSize_.y, x, x + patchSize_.x);
 }
 
-Int2 Synthesizer::pickPatchBegRandomly(
-    const Image2D<Texel>       &texels,
-    std::default_random_engine &rng,
-    bool                       *hasHole,
-    Int2                       *holeBeg) const
+ImageView2D<RGB> Synthesizer::pickPatchByMatching(
+    const Image2D<RGB>         &src,
+    const TexelPlanes          &texels,
+    const PatchHistory         &patchHistory,
+    const Int2                 &patchBeg,
+    PatchMatcher               &patchMatcher,
+    std::default_random_engine &rng) const
 {
-    if(hasHole)
+    // covered texels under the patch
+
+    patchMatcher.clearTarget();
+
+    const Int2 beg = { std::max(patchBeg.x, 0), std::max(patchBeg.y, 0) };
+    const Int2 end = {
+        std::min(patchBeg.x + patchSize_.x, texels.width()),
+        std::min(patchBeg.y + patchSize_.y, texels.height())
+    };
+
+    // longest band of fully covered rows
+    int bandBeg = beg.y, bandEnd = beg.y;
+    int runBeg = beg.y;
+
+    for(int y = beg.y; y < end.y; ++y)
     {
-        *holeBeg = findNextHoleBeg(texels);
-        *hasHole = holeBeg->x >= 0;
+        bool isRowCovered = true;
+        for(int x = beg.x; x < end.x; ++x)
+        {
+            const int patchIndex = texels.getPatchIndex(y, x);
+            if(patchIndex >= 0)
+            {
+                patchMatcher.setTargetTexel(
+                    Int2(x, y) - patchBeg,
+                    patchHistory.getRGB(patchIndex, x, y));
+            }
+            else
+                isRowCovered = false;
+        }
+
+        if(!isRowCovered)
+            runBeg = y + 1;
+        else if(y + 1 - runBeg > bandEnd - bandBeg)
+        {
+            bandBeg = runBeg;
+            bandEnd = y + 1;
+        }
     }
 
-    if(!hasHole || !*hasHole)
-    {
-        std::uniform_int_distribution disX(-patchSize_.x + 1, texels.width() - 1);
-        std::uniform_int_distribution disY(-patchSize_.y + 1, texels.height() - 1);
+    const bool useSubPatch = patchPlacement_ == SubPatchMatching &&
+                             bandBeg < bandEnd && beg.x < end.x;
 
-        const int x = disX(rng);
-        const int y = disY(rng);
+    const auto [x, y] = useSubPatch ?
+        patchMatcher.matchSubPatch(
+            Int2(beg.x, bandBeg) - patchBeg,
+            { end.x - beg.x, bandEnd - bandBeg }, rng) :
+        patchMatcher.matchEntirePatch(rng);
+    return src.subview(y, y + patchSize_.y, x, x + patchSize_.x);
+}
 
-        return { x, y };
-    }
+Int2 Synthesizer::pickPatchBegRandomly(
+    const Int2                 &dstSize,
+    std::default_random_engine &rng) const
+{
+    std::uniform_int_distribution disX(-patchSize_.x + 1, dstSize.x - 1);
+    std::uniform_int_distribution disY(-patchSize_.y + 1, dstSize.y - 1);
 
+    const int x = disX(rng);
+    const int y = disY(rng);
+
+    return { x, y };
+}
+
+Int2 Synthesizer::pickPatchBegAround(
+    const Int2                 &position,
+    std::default_random_engine &rng) const
+{
     std::uniform_int_distribution disX(
-        holeBeg->x - patchSize_.x * 2 / 3, holeBeg->x - patchSize_.x / 3);
+        position.x - patchSize_.x * 2 / 3, position.x - patchSize_.x / 3);
     std::uniform_int_distribution disY(
-        holeBeg->y - patchSize_.y * 2 / 3, holeBeg->y - patchSize_.y / 3);
+        position.y - patchSize_.y * 2 / 3, position.y - patchSize_.y / 3);
 
     const int x = disX(rng);
     const int y = disY(rng);
@@ -178,127 +803,269 @@ Int2 Synthesizer::pickPatchBegRandomly(
     return { x, y };
 }
 
-Int2 Synthesizer::findNextHoleBeg(const Image2D<Texel> &texels) const
+void Synthesizer::addWavefrontPatchBegs(
+    const HoleTracker          &holeTracker,
+    const Int2                 &holeBeg,
+    const Int2                 &dstSize,
+    int                         batchSize,
+    std::vector<Int2>          &patchBegs,
+    std::default_random_engine &rng) const
 {
-    for(int y = 0; y < texels.height(); ++y)
+    // a row joins the wavefront when the row above it is filled one patch
+    // width beyond its first hole, so that the patch around the hole
+    // overlaps existing content on its top side. this gives a diagonal
+    // front when holes are filled from top-left to bottom-right
+
+    int aboveHoleX = holeBeg.x;
+
+    for(int y = holeBeg.y + 1;
+        y < dstSize.y && int(patchBegs.size()) < batchSize; ++y)
     {
-        for(int x = 0; x < texels.width(); ++x)
+        const int holeX = holeTracker.findFirstHoleInRow(y);
+
+        const bool isAboveAhead =
+            aboveHoleX >= std::min(holeX + patchSize_.x, dstSize.x);
+        aboveHoleX = holeX;
+
+        if(holeX >= dstSize.x || !isAboveAhead)
+            continue;
+
+        const Int2 patchBeg = pickPatchBegAround({ holeX, y }, rng);
+
+        const bool hasConflict = std::any_of(
+            patchBegs.begin(), patchBegs.end(), [&](const Int2 &otherBeg)
         {
-            if(texels(y, x).patchIndex < 0)
-                return { x, y };
-        }
+            return isConflicting(patchBeg, otherBeg);
+        });
+
+        if(!hasConflict)
+            patchBegs.push_back(patchBeg);
     }
-    return { -1, -1 };
 }
 
-void Synthesizer::updateSeamInfo(
-    Image2D<Texel>         &texels,
-    const std::set<Edge *> &cut) const
+bool Synthesizer::isConflicting(
+    const Int2 &aPatchBeg, const Int2 &bPatchBeg) const noexcept
 {
-    for(int y = 0; y < texels.height(); ++y)
+    // patches dilated by one texel intersect
+
+    return std::abs(aPatchBeg.x - bPatchBeg.x) < patchSize_.x + 1 &&
+           std::abs(aPatchBeg.y - bPatchBeg.y) < patchSize_.y + 1;
+}
+
+size_t Synthesizer::partitionPlacements(
+    const std::vector<Int2>       &patchBegs,
+    std::vector<std::vector<int>> &sets) const
+{
+    // sets left over from earlier calls are cleared but kept for their
+    // storage
+
+    for(auto &set : sets)
+        set.clear();
+    size_t setCount = 0;
+
+    // each placement goes to the first set it doesn't conflict with
+
+    for(int i = 0; i < int(patchBegs.size()); ++i)
     {
-        for(int x = 0; x < texels.width(); ++x)
+        const auto setsEnd = sets.begin() + setCount;
+        auto it = std::find_if(
+            sets.begin(), setsEnd, [&](const std::vector<int> &set)
         {
-            texels(y, x).keepXPosSeam = false;
-            texels(y, x).keepYPosSeam = false;
+            return std::none_of(set.begin(), set.end(), [&](int j)
+            {
+                return isConflicting(patchBegs[i], patchBegs[j]);
+            });
+        });
+
+        if(it == setsEnd)
+        {
+            if(setCount == sets.size())
+                sets.emplace_back();
+            it = sets.begin() + setCount++;
         }
+        it->push_back(i);
     }
 
-    for(auto e : cut)
+    return setCount;
+}
+
+int Synthesizer::computeSeamCost(
+    const TexelPlanes  &texels,
+    const PatchHistory &patchHistory,
+    const Int2         &position,
+    bool                isHori) const noexcept
+{
+    const Int2 s = position;
+    const Int2 t = isHori ? Int2(s.x + 1, s.y) : Int2(s.x, s.y + 1);
+
+    const int A = texels.getPatchIndex(s.y, s.x);
+    const int B = texels.getPatchIndex(t.y, t.x);
+    if(A < 0 || B < 0 || A == B)
+        return 0;
+
+    // a patch covers its interior only, so both patches cover s & t
+
+    return GraphBuilder::computeSeamCost(
+        patchHistory.getRGB(A, s.x, s.y), patchHistory.getRGB(A, t.x, t.y),
+        patchHistory.getRGB(B, s.x, s.y), patchHistory.getRGB(B, t.x, t.y));
+}
+
+void Synthesizer::collectSeams(
+    const TexelPlanes  &texels,
+    const Graph        &graph,
+    const MinCutResult &minCut,
+    std::vector<Seam>  &newSeams) const
+{
+    using VertexType = Graph::VertexType;
+
+    newSeams.clear();
+
+    for(auto e : minCut.cut)
     {
-        Vertex *a = e->a, *b = e->b;
+        Graph::Index a = graph.getEdgeA(e), b = graph.getEdgeB(e);
+        VertexType aType = graph.getVertexType(a);
+        VertexType bType = graph.getVertexType(b);
 
         // normal edge
 
-        if(a->type == Vertex::Texel && b->type == Vertex::Texel)
+        if(aType == VertexType::Texel && bType == VertexType::Texel)
         {
-            Int2 pos; bool hori;
+            const Int2 &aPos = graph.getVertexPosition(a);
+            const Int2 &bPos = graph.getVertexPosition(b);
 
-            if(a->position.y == b->position.y)
-            {
-                hori = true;
-                pos = (a->position.x < b->position.x ? a : b)->position;
-            }
-            else
-            {
-                hori = false;
-                pos = (a->position.y < b->position.y ? a : b)->position;
-            }
+            Seam seam;
+            seam.cost = graph.getEdgeCapacity(e);
 
-            auto &texel = texels(pos.y, pos.x);
-            if(hori)
+            if(aPos.y == bPos.y)
             {
-                texel.xPosSeamCost = e->capacity;
-                texel.keepXPosSeam = true;
+                seam.isHori   = true;
+                seam.position = aPos.x < bPos.x ? aPos : bPos;
             }
             else
             {
-                texel.yPosSeamCost = e->capacity;
-                texel.keepYPosSeam = true;
+                seam.isHori   = false;
+                seam.position = aPos.y < bPos.y ? aPos : bPos;
             }
 
+            newSeams.push_back(seam);
             continue;
         }
 
-        // dummy edge
+        // seam edge. seam vertex is positioned at the texel holding the
+        // seam, whose cost is kept
 
-        if(b->type == Vertex::DummySrc)
+        if(bType == VertexType::HoriSeam || bType == VertexType::VertSeam)
+        {
             std::swap(a, b);
+            std::swap(aType, bType);
+        }
 
-        if(a->type == Vertex::DummySrc)
-        {
-            assert(b->type == Vertex::HoriSeam ||
-                   b->type == Vertex::VertSeam);
+        assert(aType == VertexType::HoriSeam ||
+               aType == VertexType::VertSeam);
+        assert(bType == VertexType::Texel);
 
-            if(b->type == Vertex::HoriSeam)
-            {
-                const Int2 pos = b->edges[Vertex::EDGE_NEG_X]
-                    ->another(b)->position;
-                texels(pos.y, pos.x).keepXPosSeam = true;
-            }
-            else
-            {
-                const Int2 pos = b->edges[Vertex::EDGE_NEG_Y]
-                    ->another(b)->position;
-                texels(pos.y, pos.x).keepYPosSeam = true;
-            }
+        Seam seam;
+        seam.position = graph.getVertexPosition(a);
+        seam.isHori   = aType == VertexType::HoriSeam;
 
-            continue;
-        }
+        seam.cost = texels.getSeamCost(
+            seam.position.y, seam.position.x, seam.isHori);
 
-        // seam edge
+        newSeams.push_back(seam);
+    }
 
-        if(b->type == Vertex::HoriSeam || b->type == Vertex::VertSeam)
-            std::swap(a, b);
+    // only seam vertices have finite t-links. a cut one keeps the seam
 
-        if(a->type == Vertex::HoriSeam)
-        {
-            assert(b->type == Vertex::Texel);
-            const auto [x, y] = a->position.x < b->position.x ?
-                a->position : b->position;
-            texels(y, x).keepXPosSeam = true;
+    for(auto v : minCut.cutTerminalLinks)
+    {
+        const VertexType type = graph.getVertexType(v);
+        assert(type == VertexType::HoriSeam || type == VertexType::VertSeam);
 
-            continue;
-        }
+        Seam seam;
+        seam.position = graph.getVertexPosition(v);
+        seam.isHori   = type == VertexType::HoriSeam;
 
-        if(a->type == Vertex::VertSeam)
-        {
-            assert(b->type == Vertex::Texel);
-            const auto [x, y] = a->position.y < b->position.y ?
-                a->position : b->position;
-            texels(y, x).keepYPosSeam = true;
-        }
+        seam.cost = texels.getSeamCost(
+            seam.position.y, seam.position.x, seam.isHori);
+
+        newSeams.push_back(seam);
     }
+}
 
+void Synthesizer::updateSeamInfo(
+    TexelPlanes       &texels,
+    std::vector<Seam> &newSeams,
+    std::vector<Seam> &seams) const
+{
+    // only seams of the last cuts have nonzero costs. clear them and
+    // write the new ones
+
+    for(auto &seam : seams)
+        texels.setSeamCost(seam.position.y, seam.position.x, seam.isHori, 0);
+
+    for(auto &seam : newSeams)
+    {
+        texels.setSeamCost(
+            seam.position.y, seam.position.x, seam.isHori, seam.cost);
+    }
+
+    seams.swap(newSeams);
+
+#ifndef NDEBUG
+    // same state as clearing all seams off the new cuts over the whole
+    // output, as the full rescan did
+    for(auto &seam : seams)
+        texels.setSeamCost(seam.position.y, seam.position.x, seam.isHori, 0);
     for(int y = 0; y < texels.height(); ++y)
     {
         for(int x = 0; x < texels.width(); ++x)
+            assert(!texels.getSeamCost(y, x, true) &&
+                   !texels.getSeamCost(y, x, false));
+    }
+    for(auto &seam : seams)
+    {
+        texels.setSeamCost(
+            seam.position.y, seam.position.x, seam.isHori, seam.cost);
+    }
+#endif
+}
+
+void Synthesizer::updateSeamCostSampler(
+    const TexelPlanes  &texels,
+    const PatchHistory &patchHistory,
+    const Int2         &patchBeg,
+    int                 patchIndex,
+    SeamCostSampler    &seamCostSampler) const
+{
+    auto updateSeam = [&](int x, int y, bool isHori)
+    {
+        seamCostSampler.setSeamCost(
+            { x, y }, isHori,
+            computeSeamCost(texels, patchHistory, { x, y }, isHori));
+    };
+
+    // pairs between two texels of the patch are updated once, by the one
+    // with smaller coordinates
+
+    const Int2 patchEnd = patchBeg + patchSize_;
+    for(int y = std::max(patchBeg.y, 0);
+        y < std::min(patchEnd.y, texels.height()); ++y)
+    {
+        for(int x = std::max(patchBeg.x, 0);
+            x < std::min(patchEnd.x, texels.width()); ++x)
         {
-            auto &texel = texels(y, x);
-            if(!texel.keepXPosSeam)
-                texel.xPosSeamCost = 0;
-            if(!texel.keepYPosSeam)
-                texel.yPosSeamCost = 0;
+            if(texels.getPatchIndex(y, x) != patchIndex)
+                continue;
+
+            if(x + 1 < texels.width())
+                updateSeam(x, y, true);
+            if(y + 1 < texels.height())
+                updateSeam(x, y, false);
+
+            if(x > 0 && texels.getPatchIndex(y, x - 1) != patchIndex)
+                updateSeam(x - 1, y, true);
+            if(y > 0 && texels.getPatchIndex(y - 1, x) != patchIndex)
+                updateSeam(x, y - 1, false);
         }
     }
 }
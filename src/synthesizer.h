@@ -1,7 +1,9 @@
 #pragma once
 
+#include <cstdint>
+#include <limits>
 #include <random>
-#include <set>
+#include <vector>
 
 #include <agz/utility/texture.h>
 
@@ -19,8 +21,13 @@ using Image2D = agz::texture::texture2d_t<T>;
 template<typename T>
 using ImageView2D = agz::texture::texture2d_view_t<T, true>;
 
-struct Edge;
-struct Texel;
+class Graph;
+class HoleTracker;
+class PatchHistory;
+class PatchMatcher;
+class SeamCostSampler;
+class TexelPlanes;
+struct MinCutResult;
 
 class Synthesizer
 {
@@ -28,13 +35,66 @@ public:
 
     enum PatchPlacementStrategy
     {
-        Random
+        Random,
+        EntirePatchMatching,
+        SubPatchMatching
     };
 
+    enum class MaxFlowSolverType
+    {
+        Auto,        // chosen by graph size
+        BK,          // Boykov-Kolmogorov
+        PushRelabel, // parallel push-relabel
+        Dinic,       // Dinic with capacity scaling
+    };
+
+    // optional layers wrapped around the max flow solver, each of which can
+    // be enabled independently of the solver type
+    struct MaxFlowSolverLayers
+    {
+        bool reduction    = true;  // exact. see ReducingSolver
+        bool coarseToFine = false; // approximate. see CoarseToFineSolver
+        bool planar       = false; // exact. see PlanarSolver
+    };
+
+    // with a positive time budget, holes are always filled with exact min
+    // cuts, and additional patches are pasted only until the budget runs
+    // out. min cuts of additional patches are bounded by the budget as well
     void setParams(
         const Int2            &patchSize,
         int                    additionalPatchCount,
-        PatchPlacementStrategy patchPlacement) noexcept;
+        PatchPlacementStrategy patchPlacement,
+        MaxFlowSolverType      maxFlowSolver,
+        int                    timeBudgetMs) noexcept;
+
+    // layers of both the shared solver & the serial ones used for concurrent
+    // cuts
+    void setMaxFlowSolverLayers(const MaxFlowSolverLayers &layers) noexcept;
+
+    // stop pasting additional patches once the total cost of all seams in
+    // the output, averaged over the last windowSize patches, drops by less
+    // than minImprovement (relative) from its mean over the windowSize
+    // patches before. windowSize <= 0 disables the early stop
+    void setConvergenceParams(
+        int   windowSize,
+        float minImprovement) noexcept;
+
+    // up to batchSize placements are drawn at once, and partitioned into
+    // sets of non-conflicting patches. patches in a set are cut concurrently.
+    // batchSize <= 1 places patches one by one
+    void setPatchBatchSize(int batchSize) noexcept;
+
+    // each patch is chosen from candidateCount placements evaluated in
+    // parallel: the one with the lowest cut cost per newly covered texel is
+    // kept. with more than one candidate, patch batch size is ignored
+    void setCandidateCount(int candidateCount) noexcept;
+
+    // additional patches are pasted by workers without a global order: each
+    // one builds & cuts its graph against the current texels, and commits
+    // only when no other commit touched its patch meanwhile; otherwise it
+    // retries. results depend on thread timing. ignored with more than one
+    // candidate
+    void setOptimisticRefinement(bool enabled) noexcept;
 
     Image2D<RGB> generate(
         const Image2D<RGB> &src,
@@ -46,23 +106,114 @@ private:
         const Image2D<RGB>         &src,
         std::default_random_engine &rng) const;
 
+    // src patch matching the output under patchBeg. with sub-patch matching,
+    // the longest band of fully covered rows under the patch is compared
+    // when there is one
+    ImageView2D<RGB> pickPatchByMatching(
+        const Image2D<RGB>         &src,
+        const TexelPlanes          &texels,
+        const PatchHistory         &patchHistory,
+        const Int2                 &patchBeg,
+        PatchMatcher               &patchMatcher,
+        std::default_random_engine &rng) const;
+
     Int2 pickPatchBegRandomly(
-        const Image2D<Texel>       &texels,
-        std::default_random_engine &rng,
-        bool                       *hasHole,
-        Int2                       *holeBeg) const;
+        const Int2                 &dstSize,
+        std::default_random_engine &rng) const;
+
+    // the position lies in the middle third of the patch
+    Int2 pickPatchBegAround(
+        const Int2                 &position,
+        std::default_random_engine &rng) const;
+
+    // add placements around holes on the wavefront below holeBeg, until
+    // there are batchSize ones
+    void addWavefrontPatchBegs(
+        const HoleTracker          &holeTracker,
+        const Int2                 &holeBeg,
+        const Int2                 &dstSize,
+        int                         batchSize,
+        std::vector<Int2>          &patchBegs,
+        std::default_random_engine &rng) const;
 
-    Int2 findNextHoleBeg(const Image2D<Texel> &texels) const;
+    // whether two patches may touch the same texel or texel pair
+    bool isConflicting(
+        const Int2 &aPatchBeg, const Int2 &bPatchBeg) const noexcept;
 
+    // group indices of placements into sets of non-conflicting ones, and
+    // return the number of sets. sets are written to the front of the
+    // vector, whose storage is reused
+    size_t partitionPlacements(
+        const std::vector<Int2>       &patchBegs,
+        std::vector<std::vector<int>> &sets) const;
+
+    // seam between a texel and its +x/+y neighbor
+    struct Seam
+    {
+        Int2 position;
+        bool isHori = true;
+        int  cost   = 0;
+    };
+
+    // cost of the seam between a texel and its +x/+y neighbor, computed from
+    // the patches now covering them. zero if they aren't different patches
+    int computeSeamCost(
+        const TexelPlanes  &texels,
+        const PatchHistory &patchHistory,
+        const Int2         &position,
+        bool                isHori) const noexcept;
+
+    // overwrite newSeams with seams on the cut. reads texels on the cut only
+    void collectSeams(
+        const TexelPlanes  &texels,
+        const Graph        &graph,
+        const MinCutResult &minCut,
+        std::vector<Seam>  &newSeams) const;
+
+    // replace seams of the last cuts with the ones of the new cuts. storage
+    // of the old seams is moved to newSeams for reuse
     void updateSeamInfo(
-        Image2D<Texel>        &texels,
-        const std::set<Edge*> &cut) const;
+        TexelPlanes       &texels,
+        std::vector<Seam> &newSeams,
+        std::vector<Seam> &seams) const;
+
+    // recompute sampled costs of seams touching texels just assigned to the
+    // patch. the sampler keeps every seam in the output, not only the ones
+    // of the last cuts
+    void updateSeamCostSampler(
+        const TexelPlanes  &texels,
+        const PatchHistory &patchHistory,
+        const Int2         &patchBeg,
+        int                 patchIndex,
+        SeamCostSampler    &seamCostSampler) const;
 
     int additionalPatchCount_ = 0;
 
     Int2 patchSize_;
 
     PatchPlacementStrategy patchPlacement_ = Random;
+
+    MaxFlowSolverType maxFlowSolver_ = MaxFlowSolverType::Auto;
+
+    MaxFlowSolverLayers maxFlowSolverLayers_;
+
+    int timeBudgetMs_ = 0;
+
+    int   convergenceWindow_    = 0;
+    float convergenceThreshold_ = 0;
+
+    int patchBatchSize_ = 1;
+
+    int candidateCount_ = 1;
+
+    bool optimisticRefinement_ = false;
+
+    // patch index used by graph building before the patch is committed
+    static constexpr int PENDING_PATCH_INDEX =
+        std::numeric_limits<int>::max();
+
+    // texels are grouped into square tiles for commit conflict detection
+    static constexpr int VERSION_TILE_SIZE = 16;
 };
 
 GCTS_END
@@ -0,0 +1,61 @@
+#include <cassert>
+
+#include "texelPlanes.h"
+
+GCTS_BEGIN
+
+TexelPlanes::TexelPlanes(const Int2 &size)
+    : width_(size.x), height_(size.y)
+{
+    const size_t count = size_t(size.x) * size.y;
+    patchIndices_.assign(count, -1);
+    xPosSeamCosts_.assign(count, 0);
+    yPosSeamCosts_.assign(count, 0);
+}
+
+int TexelPlanes::width() const noexcept
+{
+    return width_;
+}
+
+int TexelPlanes::height() const noexcept
+{
+    return height_;
+}
+
+Texel TexelPlanes::operator()(int y, int x) const noexcept
+{
+    const size_t i = toIndex(y, x);
+    return { patchIndices_[i], xPosSeamCosts_[i], yPosSeamCosts_[i] };
+}
+
+int TexelPlanes::getPatchIndex(int y, int x) const noexcept
+{
+    return patchIndices_[toIndex(y, x)];
+}
+
+void TexelPlanes::setPatchIndex(int y, int x, int patchIndex) noexcept
+{
+    patchIndices_[toIndex(y, x)] = patchIndex;
+}
+
+int TexelPlanes::getSeamCost(int y, int x, bool isHori) const noexcept
+{
+    const size_t i = toIndex(y, x);
+    return isHori ? xPosSeamCosts_[i] : yPosSeamCosts_[i];
+}
+
+void TexelPlanes::setSeamCost(int y, int x, bool isHori, int cost) noexcept
+{
+    assert(0 <= cost && cost <= MAX_SEAM_COST);
+    const size_t i = toIndex(y, x);
+    (isHori ? xPosSeamCosts_[i] : yPosSeamCosts_[i]) = uint16_t(cost);
+}
+
+size_t TexelPlanes::toIndex(int y, int x) const noexcept
+{
+    assert(0 <= x && x < width_ && 0 <= y && y < height_);
+    return size_t(y) * width_ + x;
+}
+
+GCTS_END
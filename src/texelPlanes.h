@@ -0,0 +1,61 @@
+#pragma once
+
+#include "synthesizer.h"
+
+GCTS_BEGIN
+
+// unpacked state of a texel
+struct Texel
+{
+    int patchIndex   = -1; // covered by which patch
+    int xPosSeamCost = 0;  // seam with +x neighbor
+    int yPosSeamCost = 0;  // seam with +y neighbor
+};
+
+/*
+ * persistent per-texel state of the output, kept for the whole synthesis.
+ *
+ * each field is stored in its own plane: 32-bit patch indices (negative for
+ * uncovered texels) and 16-bit seam costs, 8 bytes per texel in total. scans
+ * over a single field only touch its plane. graph vertices are not kept here;
+ * each graph building allocates its own ones for the patch only.
+ *
+ * different texels can be written concurrently.
+ */
+class TexelPlanes
+{
+public:
+
+    // seam costs are sums of 6 color channel differences
+    static constexpr int MAX_SEAM_COST = 6 * 255;
+
+    explicit TexelPlanes(const Int2 &size);
+
+    int width() const noexcept;
+
+    int height() const noexcept;
+
+    Texel operator()(int y, int x) const noexcept;
+
+    int getPatchIndex(int y, int x) const noexcept;
+
+    void setPatchIndex(int y, int x, int patchIndex) noexcept;
+
+    // cost of the seam with +x (isHori) or +y neighbor
+    int getSeamCost(int y, int x, bool isHori) const noexcept;
+
+    void setSeamCost(int y, int x, bool isHori, int cost) noexcept;
+
+private:
+
+    size_t toIndex(int y, int x) const noexcept;
+
+    int width_  = 0;
+    int height_ = 0;
+
+    std::vector<int32_t>  patchIndices_;
+    std::vector<uint16_t> xPosSeamCosts_;
+    std::vector<uint16_t> yPosSeamCosts_;
+};
+
+GCTS_END
@@ -0,0 +1,112 @@
+#include <algorithm>
+
+#include "threadPool.h"
+
+GCTS_BEGIN
+
+ThreadPool::ThreadPool(int threadCount)
+{
+    if(threadCount <= 0)
+        threadCount = std::max(1, int(std::thread::hardware_concurrency()));
+
+    for(int i = 1; i < threadCount; ++i)
+        workers_.emplace_back([this, i] { workerMain(i); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lk(mutex_);
+        stop_ = true;
+    }
+    startCond_.notify_all();
+
+    for(auto &w : workers_)
+        w.join();
+}
+
+int ThreadPool::getThreadCount() const noexcept
+{
+    return int(workers_.size()) + 1;
+}
+
+void ThreadPool::runParallelFor(
+    size_t      count,
+    const void *func,
+    ChunkFunc   chunkFunc,
+    size_t      minChunkSize)
+{
+    if(!count)
+        return;
+
+    // small loops are not worth waking up workers
+    const size_t threadCount = workers_.size() + 1;
+    if(threadCount == 1 || count < 2 * minChunkSize)
+    {
+        chunkFunc(func, 0, 0, count);
+        return;
+    }
+
+    {
+        std::lock_guard lk(mutex_);
+        func_      = func;
+        chunkFunc_ = chunkFunc;
+        count_     = count;
+        chunkSize_ = std::max(minChunkSize, count / (8 * threadCount));
+        nextChunk_ = 0;
+
+        ++generation_;
+        runningWorkers_ = int(workers_.size());
+    }
+    startCond_.notify_all();
+
+    runChunks(0);
+
+    std::unique_lock lk(mutex_);
+    finishCond_.wait(lk, [&] { return runningWorkers_ == 0; });
+    func_ = nullptr;
+}
+
+void ThreadPool::workerMain(int threadIndex)
+{
+    int lastGeneration = 0;
+
+    for(;;)
+    {
+        {
+            std::unique_lock lk(mutex_);
+            startCond_.wait(lk, [&]
+            {
+                return stop_ || generation_ != lastGeneration;
+            });
+            if(stop_)
+                return;
+            lastGeneration = generation_;
+        }
+
+        runChunks(threadIndex);
+
+        bool isLast;
+        {
+            std::lock_guard lk(mutex_);
+            isLast = --runningWorkers_ == 0;
+        }
+        if(isLast)
+            finishCond_.notify_one();
+    }
+}
+
+void ThreadPool::runChunks(int threadIndex)
+{
+    for(;;)
+    {
+        const size_t beg = nextChunk_.fetch_add(chunkSize_);
+        if(beg >= count_)
+            return;
+
+        chunkFunc_(
+            func_, threadIndex, beg, std::min(count_, beg + chunkSize_));
+    }
+}
+
+GCTS_END
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "synthesizer.h"
+
+GCTS_BEGIN
+
+/*
+ * fixed set of worker threads executing data-parallel loops.
+ * the calling thread takes part in each loop as thread 0
+ */
+class ThreadPool
+{
+public:
+
+    // threadCount <= 0 means hardware concurrency
+    explicit ThreadPool(int threadCount = 0);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&)            = delete;
+    ThreadPool &operator=(const ThreadPool&) = delete;
+
+    int getThreadCount() const noexcept;
+
+    static constexpr size_t MIN_CHUNK_SIZE = 256;
+
+    /*
+     * [0, count) is divided into chunks of at least minChunkSize elements,
+     * and func(threadIndex, beg, end) is called for each chunk [beg, end).
+     * returns after all chunks are done. func must not call parallelFor
+     */
+    template<typename Func>
+    void parallelFor(
+        size_t      count,
+        const Func &func,
+        size_t      minChunkSize = MIN_CHUNK_SIZE);
+
+private:
+
+    // func is only referred to by the job, so that loops never allocate as
+    // std::function may do for large closures
+    using ChunkFunc = void(*)(const void *func, int, size_t, size_t);
+
+    void runParallelFor(
+        size_t      count,
+        const void *func,
+        ChunkFunc   chunkFunc,
+        size_t      minChunkSize);
+
+    void workerMain(int threadIndex);
+
+    void runChunks(int threadIndex);
+
+    std::vector<std::thread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable startCond_;
+    std::condition_variable finishCond_;
+
+    bool stop_ = false;
+
+    // current job
+    const void *func_      = nullptr;
+    ChunkFunc   chunkFunc_ = nullptr;
+
+    size_t count_     = 0;
+    size_t chunkSize_ = 1;
+
+    std::atomic<size_t> nextChunk_ = 0;
+
+    int generation_     = 0;
+    int runningWorkers_ = 0;
+};
+
+template<typename Func>
+void ThreadPool::parallelFor(
+    size_t      count,
+    const Func &func,
+    size_t      minChunkSize)
+{
+    auto chunkFunc = [](const void *f, int threadIndex, size_t beg, size_t end)
+    {
+        (*static_cast<const Func*>(f))(threadIndex, beg, end);
+    };
+    runParallelFor(count, &func, chunkFunc, minChunkSize);
+}
+
+GCTS_END
@@ -0,0 +1,208 @@
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "bkSolver.h"
+#include "threadPool.h"
+
+/*
+ * every max flow solver type & layer combination is checked against BKSolver
+ * on random grid graphs with seam vertices, laid out as GraphBuilder does.
+ * exact solvers must give the same src side, and coarse-to-fine ones a valid
+ * cut no cheaper than the min cut
+ */
+
+GCTS_BEGIN
+
+struct NamedSolver
+{
+    std::string                    name;
+    std::unique_ptr<MaxFlowSolver> solver;
+    bool                           isExact = true;
+};
+
+// src texels on the left column, sink texels on the right one. without
+// seams, the graph is handled by PlanarSolver
+static void buildRandomGraph(
+    int width, int height, bool hasSeams,
+    std::default_random_engine &rng, Graph &graph)
+{
+    std::uniform_int_distribution<int> capacityDis(0, 99);
+    std::bernoulli_distribution        edgeDis(0.9);
+    std::bernoulli_distribution        seamDis(0.3);
+
+    graph.clear();
+    graph.initGrid({ 0, 0 }, { width, height });
+
+    auto addSeam = [&](Graph::Index a, Graph::Index b, bool isHori)
+    {
+        const Graph::Index s = graph.addVertex(
+            isHori ? Graph::VertexType::HoriSeam : Graph::VertexType::VertSeam,
+            graph.getVertexPosition(a));
+        graph.addEdge(a, s, capacityDis(rng));
+        graph.addEdge(b, s, capacityDis(rng));
+        graph.setTerminalCapacity(s, capacityDis(rng));
+    };
+
+    for(int y = 0; y < height; ++y)
+    {
+        for(int x = 0; x < width; ++x)
+        {
+            const Graph::Index c = Graph::Index(y) * width + x;
+
+            if(x + 1 < width)
+            {
+                if(edgeDis(rng))
+                    graph.addGridEdgeX(c, capacityDis(rng));
+                else if(hasSeams && seamDis(rng))
+                    addSeam(c, c + 1, true);
+            }
+
+            if(y + 1 < height)
+            {
+                if(edgeDis(rng))
+                    graph.addGridEdgeY(c, capacityDis(rng));
+                else if(hasSeams && seamDis(rng))
+                    addSeam(c, c + width, false);
+            }
+        }
+
+        graph.setTerminalCapacity(
+            Graph::Index(y) * width, Graph::INF_CAPACITY);
+        graph.setTerminalCapacity(
+            Graph::Index(y) * width + width - 1, -Graph::INF_CAPACITY);
+    }
+
+    graph.buildAdjacency();
+}
+
+static bool isSeparating(const Graph &graph, const MinCutResult &result)
+{
+    for(Graph::Index v = 0; v < graph.getVertexCount(); ++v)
+    {
+        if(graph.isSrc(v) != result.reachableVertices[v] &&
+           (graph.isSrc(v) || graph.isSink(v)))
+            return false;
+    }
+    return true;
+}
+
+static std::int64_t getCutCost(const Graph &graph, const MinCutResult &result)
+{
+    std::int64_t cost = 0;
+    for(auto e : result.cut)
+        cost += graph.getEdgeCapacity(e);
+    for(auto v : result.cutTerminalLinks)
+        cost += std::abs(graph.getTerminalCapacity(v));
+    return cost;
+}
+
+// all layer combinations, or only coarse-to-fine without other layers
+static std::vector<NamedSolver> createSolvers(
+    ThreadPool &threadPool, bool coarseToFineOnly)
+{
+    using Type = Synthesizer::MaxFlowSolverType;
+
+    const std::pair<Type, const char *> types[] = {
+        { Type::Auto,        "auto"  },
+        { Type::BK,          "bk"    },
+        { Type::PushRelabel, "pr"    },
+        { Type::Dinic,       "dinic" },
+    };
+
+    std::vector<NamedSolver> ret;
+    for(auto &[type, typeName] : types)
+    {
+        for(int mask = 0; mask < 8; ++mask)
+        {
+            if(coarseToFineOnly && mask != 2)
+                continue;
+
+            Synthesizer::MaxFlowSolverLayers layers;
+            layers.reduction    = mask & 1;
+            layers.coarseToFine = mask & 2;
+            layers.planar       = mask & 4;
+
+            NamedSolver solver;
+            solver.name = typeName;
+            if(layers.reduction)
+                solver.name += "+reduce";
+            if(layers.coarseToFine)
+                solver.name += "+coarseToFine";
+            if(layers.planar)
+                solver.name += "+planar";
+
+            solver.solver = wrapMaxFlowSolver(
+                createMaxFlowSolver(type, threadPool), layers);
+            solver.isExact = !layers.coarseToFine;
+
+            ret.push_back(std::move(solver));
+        }
+    }
+    return ret;
+}
+
+// returns the number of failed checks
+static int check(const Graph &graph, std::vector<NamedSolver> &solvers)
+{
+    BKSolver reference;
+    const MinCutResult expected = reference.findMinCut(graph);
+    const std::int64_t expectedCost = getCutCost(graph, expected);
+
+    int failCount = 0;
+    for(auto &[name, solver, isExact] : solvers)
+    {
+        const MinCutResult &result = solver->findMinCut(graph);
+        const std::int64_t cost = getCutCost(graph, result);
+
+        const bool isValid =
+            isSeparating(graph, result) &&
+            (isExact ? cost == expectedCost &&
+                       result.reachableVertices == expected.reachableVertices
+                     : cost >= expectedCost);
+
+        if(!isValid)
+        {
+            std::cout << name << ": cut cost " << cost << ", expected "
+                      << expectedCost << std::endl;
+            ++failCount;
+        }
+    }
+    return failCount;
+}
+
+static int run()
+{
+    ThreadPool threadPool;
+    auto solvers = createSolvers(threadPool, false);
+
+    std::default_random_engine rng(0);
+    std::uniform_int_distribution<int> sizeDis(2, 40);
+
+    Graph graph;
+    int failCount = 0;
+
+    for(int i = 0; i < 200; ++i)
+    {
+        buildRandomGraph(sizeDis(rng), sizeDis(rng), i % 2, rng, graph);
+        failCount += check(graph, solvers);
+    }
+
+    // large enough to be solved coarse-to-fine. other layers are only
+    // combined with it on small graphs to keep the test short
+
+    auto coarseToFineSolvers = createSolvers(threadPool, true);
+
+    buildRandomGraph(600, 600, true, rng, graph);
+    failCount += check(graph, coarseToFineSolvers);
+
+    std::cout << failCount << " failed checks" << std::endl;
+    return failCount ? 1 : 0;
+}
+
+GCTS_END
+
+int main()
+{
+    return gcts::run();
+}